@@ -0,0 +1,90 @@
+#!/bin/sh
+# Copyright (C) 2020-2025 Andy Kurnia.
+
+# end-to-end benchmark, run by make bench.
+# every command under every layout on synthetic lexicons from lexgen.
+# appends one json object per run to the results file (default bench_output.txt).
+# BENCH_LANGS, BENCH_SIZES, BENCH_LAYOUTS and BENCH_SEED override the defaults.
+
+set -u
+
+results=${1:-bench_output.txt}
+langs=${BENCH_LANGS:-english german polish catalan}
+sizes=${BENCH_SIZES:-10000 100000 1000000 5000000}
+layouts=${BENCH_LAYOUTS:-wolges legacy magpie magpiemerged experimental hot paged profiled}
+seed=${BENCH_SEED:-1}
+data=bench_data
+
+if command -v sha256sum >/dev/null 2>&1; then
+  hash_file() { sha256sum "$1" | cut -d' ' -f1; }
+else
+  hash_file() { cksum "$1" | cut -d' ' -f1; }
+fi
+
+mkdir -p "$data" || exit 1
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+
+# record lang size layout cmd ok nodes hash stats_json
+record() {
+  # peak rss over all phases, 0 if the run died before printing stats.
+  peak_rss=$(printf '%s' "$8" | sed -n 's/.*"phase_peak_rss_kib":{\([^}]*\)}.*/\1/p' |
+    tr ',' '\n' | sed 's/.*://' | sort -n | tail -n 1)
+  seconds=$(printf '%s' "$8" | sed -n 's/.*"total_seconds":\([0-9.]*\).*/\1/p')
+  printf '{"commit":"%s","lang":"%s","size":%s,"layout":"%s","cmd":"%s","ok":%s,"seconds":%s,"peak_rss_kib":%s,"nodes":%s,"hash":"%s","stats":%s}\n' \
+    "$commit" "$1" "$2" "$3" "$4" "$5" "${seconds:-null}" "${peak_rss:-0}" "$6" "$7" "${8:-null}" >> "$results"
+  echo "$1 $2 $3 $4: ok=$5 ${seconds:-?}s ${peak_rss:-?}KiB $6 nodes"
+}
+
+for lang in $langs; do
+  for size in $sizes; do
+    words="$data/$lang-$size-$seed.txt"
+    leaves="$data/$lang-$size-$seed.csv"
+    [ -s "$words" ] || ./lexgen "$lang" words "$size" "$seed" > "$words" || exit 1
+    [ -s "$leaves" ] || ./lexgen "$lang" leaves "$size" "$seed" > "$leaves" || exit 1
+    # profiled takes as many skewed lookups of the same lexicon, a few of them misses.
+    words_profile="$data/$lang-$size-$seed.words-profile.txt"
+    leaves_profile="$data/$lang-$size-$seed.leaves-profile.txt"
+    [ -s "$words_profile" ] || ./lexgen "$lang" profile "$size" "$seed" < "$words" > "$words_profile" || exit 1
+    [ -s "$leaves_profile" ] || ./lexgen "$lang" profile "$size" "$seed" < "$leaves" > "$leaves_profile" || exit 1
+    for layout in $layouts; do
+      if [ "$layout" = wolges ]; then prefix=$lang; else prefix=$lang-$layout; fi
+      out="$data/$lang-$size-$layout"
+      for cmd in kwg kbwg kwg-dawg kwg-alpha klv2; do
+        case $cmd in
+          klv2) infile=$leaves; profile=$leaves_profile ;;
+          *) infile=$words; profile=$words_profile ;;
+        esac
+        [ "$layout" = profiled ] || profile=
+        outfile="$out.$cmd"
+        rm -f "$outfile"
+        # kwgc exits 0 even on failure, but then prints usage instead of stats.
+        stats=$(./kwgc "$prefix-$cmd" "$infile" "$outfile" ${profile:+"$profile"} --stats=json 2>/dev/null | grep '^{' | tail -n 1)
+        if [ -n "$stats" ] && [ -s "$outfile" ]; then
+          if [ "$cmd" = klv2 ]; then
+            nodes=$(od -An -tu4 -N4 "$outfile" | tr -d ' ')
+          else
+            nodes=$(($(wc -c < "$outfile") / 4))
+          fi
+          record "$lang" "$size" "$layout" "$cmd" true "$nodes" "$(hash_file "$outfile")" "$stats"
+        else
+          record "$lang" "$size" "$layout" "$cmd" false 0 "" "$stats"
+        fi
+      done
+      for cmd in read-kwg read-kwg-gaddag read-kbwg read-kbwg-gaddag read-klv2; do
+        case $cmd in
+          read-kwg*) infile=$out.kwg ;;
+          read-kbwg*) infile=$out.kbwg ;;
+          read-klv2) infile=$out.klv2 ;;
+        esac
+        [ -s "$infile" ] || continue
+        nodes=$(($(wc -c < "$infile") / 4))
+        [ "$cmd" = read-klv2 ] && nodes=$(od -An -tu4 -N4 "$infile" | tr -d ' ')
+        # the dump goes to a file so its hash can be recorded, stats come on stderr.
+        stats=$(./kwgc "$prefix-$cmd" "$infile" --stats=json 2>&1 > "$out.dump" | grep '^{' | tail -n 1)
+        if [ -n "$stats" ]; then ok=true; else ok=false; fi
+        record "$lang" "$size" "$layout" "$cmd" $ok "$nodes" "$(hash_file "$out.dump")" "$stats"
+        rm -f "$out.dump"
+      done
+    done
+  done
+done
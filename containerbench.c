@@ -0,0 +1,189 @@
+// Copyright (C) 2020-2025 Andy Kurnia.
+
+// microbenchmark for generic_vec.c and generic_khm.c, instantiated like kwgc does.
+// sizes go from fitting in L1 to well beyond the last level cache.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.c"
+
+// malloc helpers (no accounting here, so the vecs are untagged)
+
+static inline void *not_null_or_die(void *ptr) {
+  if (!ptr) { perror("not_null_or_die"); abort(); }
+  return ptr;
+}
+
+static inline void *malloc_or_die(size_t size) {
+  return not_null_or_die(malloc(size));
+}
+
+static inline void *realloc_or_die(void *ptr, size_t size) {
+  return not_null_or_die(realloc(ptr, size));
+}
+
+// same types and hash as kwgc.c, the state ones come from kwgc_state.c.
+
+#define VEC_ELT_NAME Bool
+#define VEC_ELT_T bool
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+#define VEC_ELT_NAME U64
+#define VEC_ELT_T uint64_t
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+#define VEC_ELT_NAME U32
+#define VEC_ELT_T uint32_t
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+#include "kwgc_state.c"
+
+// keys shaped like the builder's: arcs and nexts point to earlier states.
+// states[i] for i < n are distinct, n..2n are distinct misses (tile 0 never occurs in the first half).
+static KwgcState *make_states(size_t n) {
+  KwgcState *states = malloc_or_die(2 * n * sizeof(KwgcState));
+  uint64_t rng = 42;
+  for (size_t i = 0; i < 2 * n; ++i) {
+    uint64_t r = rng_next(&rng);
+    uint32_t bound = (uint32_t)(i % n) + 1;
+    states[i] = (KwgcState){
+      .arc_index = (uint32_t)((r & 0xffffffff) % bound),
+      .next_index = (uint32_t)i, // makes every key distinct.
+      .tile = i < n ? (uint8_t)(1 + ((r >> 32) % 26)) : 0,
+      .accepts = (r >> 40) & 1,
+    };
+  }
+  return states;
+}
+
+static void shuffle_u32(uint32_t *a, size_t n) {
+  uint64_t rng = 7;
+  for (size_t i = n; i > 1; --i) {
+    size_t j = (size_t)(rng_next(&rng) % i);
+    uint32_t t = a[i - 1]; a[i - 1] = a[j]; a[j] = t;
+  }
+}
+
+// best of this many runs, each doing at least MIN_OPS operations.
+#define NUM_RUNS 3
+#define MIN_OPS (1 << 22)
+
+typedef enum {
+    Op_VecPushU32,
+    Op_VecPushState,
+    Op_Insert, // presized, so no rehash.
+    Op_InsertGrow, // from the default 16 slots, so it rehashes.
+    Op_LookupHit,
+    Op_LookupMiss,
+    Op_Count,
+} Op;
+
+const char *op_names[Op_Count] = {
+  "vec_push_u32",
+  "vec_push_state",
+  "khm_insert",
+  "khm_insert_grow",
+  "khm_lookup_hit",
+  "khm_lookup_miss",
+};
+
+volatile uint64_t sink; // keeps results alive.
+
+// returns ns per op for one pass over n elements.
+static double run_once(Op op, size_t n, KwgcState *states, uint32_t *order, KhmKwgcStateU32 *filled) {
+  uint64_t t0 = now_ns();
+  uint64_t acc = 0;
+  switch (op) {
+    case Op_VecPushU32: {
+      VecU32 v = vecU32_new();
+      for (uint32_t i = 0; i < n; ++i) vecU32_push(&v, &i);
+      acc += v.ptr[n - 1];
+      vecU32_free(&v);
+      break;
+    }
+    case Op_VecPushState: {
+      VecKwgcState v = vecKwgcState_new();
+      for (size_t i = 0; i < n; ++i) vecKwgcState_push(&v, states + i);
+      acc += v.ptr[n - 1].arc_index;
+      vecKwgcState_free(&v);
+      break;
+    }
+    case Op_Insert:
+    case Op_InsertGrow: {
+      size_t cap = 16;
+      // same threshold as khm set: len + len / 3 < cap.
+      if (op == Op_Insert) while (n + n / 3 >= cap) cap <<= 1;
+      KhmKwgcStateU32 h = khmKwgcStateU32_new_cap(cap);
+      for (uint32_t i = 0; i < n; ++i) khmKwgcStateU32_set(&h, states + i, &i);
+      acc += h.len;
+      khmKwgcStateU32_free(&h);
+      break;
+    }
+    case Op_LookupHit:
+      for (size_t i = 0; i < n; ++i) acc += *khmKwgcStateU32_get(filled, states + order[i]);
+      break;
+    case Op_LookupMiss:
+      for (size_t i = 0; i < n; ++i) acc += !khmKwgcStateU32_get(filled, states + n + order[i]);
+      break;
+    case Op_Count:
+      break;
+  }
+  uint64_t t1 = now_ns();
+  sink += acc;
+  return (double)(t1 - t0) / (double)n;
+}
+
+int main(int argc, char **argv) {
+  // log2 of element counts. the map_bytes column shows how big the map got.
+  size_t min_log = 10, max_log = 24;
+  if (argc == 3) {
+    min_log = strtoul(argv[1], NULL, 10);
+    max_log = strtoul(argv[2], NULL, 10);
+  }
+  if ((argc != 1 && argc != 3) || min_log < 4 || min_log > max_log || max_log > 28) {
+    fprintf(stderr, "usage: %s [min_log2_size max_log2_size]\n", argv[0]);
+    return 2;
+  }
+  printf("%-10s %12s", "n", "map_bytes");
+  for (int op = 0; op < Op_Count; ++op) printf(" %16s", op_names[op]);
+  printf("\n");
+  for (size_t log = min_log; log <= max_log; log += 2) {
+    size_t n = (size_t)1 << log;
+    KwgcState *states = make_states(n);
+    uint32_t *order = malloc_or_die(n * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; ++i) order[i] = i;
+    shuffle_u32(order, n);
+    KhmKwgcStateU32 filled = khmKwgcStateU32_new();
+    for (uint32_t i = 0; i < n; ++i) khmKwgcStateU32_set(&filled, states + i, &i);
+    size_t map_bytes = filled.occupieds.len * (sizeof(bool) + sizeof(uint64_t) + sizeof(KwgcState) + sizeof(uint32_t));
+    printf("%-10zu %12zu", n, map_bytes);
+    size_t passes = n < MIN_OPS ? MIN_OPS / n : 1;
+    for (int op = 0; op < Op_Count; ++op) {
+      double best = 0;
+      for (int run = 0; run < NUM_RUNS; ++run) {
+        double total = 0;
+        for (size_t pass = 0; pass < passes; ++pass) total += run_once((Op)op, n, states, order, &filled);
+        total /= (double)passes;
+        if (!run || total < best) best = total;
+      }
+      printf(" %13.2fns", best);
+    }
+    printf("\n");
+    fflush(stdout);
+    khmKwgcStateU32_free(&filled);
+    free(order);
+    free(states);
+  }
+  return 0;
+}
@@ -5,6 +5,7 @@
 // usage:
 
 // define Vec for Bool, U64, K, T.
+// with VEC_ALLOC_TAGGED, there are also khmKV_new_tagged and khmKV_new_cap_tagged.
 // implement uint64_t hashFunc(KHM_K_T*).
 // implement bool eqlFunc(KHM_K_T*, KHM_K_T*).
 
@@ -22,6 +23,10 @@
 // undef KHM_K_T
 // undef KHM_K_NAME
 
+// define KHM_INSTRUMENT (before including, or with -D) to also record
+// probe lengths (of gets and sets, not rehashes), rehashes and load factor.
+// it uses clock_gettime from time.h.
+
 #define GENERIC_CONCAT_(a, b) a##b
 #define GENERIC_CONCAT(a, b) GENERIC_CONCAT_(a, b)
 
@@ -33,6 +38,39 @@
 #define KHM_VEC_V_T GENERIC_CONCAT(Vec, KHM_V_NAME)
 #define KHM_VEC_V_F(suffix) GENERIC_CONCAT(GENERIC_CONCAT(GENERIC_CONCAT(vec, KHM_V_NAME), _), suffix)
 
+#ifdef KHM_INSTRUMENT
+#ifndef GENERIC_KHM_INSTRUMENT_DEFINED
+#define GENERIC_KHM_INSTRUMENT_DEFINED
+
+// probe length = number of slots looked at after the home bucket.
+// the last histogram bucket also counts all longer probes.
+#define KHM_PROBE_HISTOGRAM_LEN 32
+
+typedef struct {
+  uint64_t probe_histogram[KHM_PROBE_HISTOGRAM_LEN];
+  uint64_t num_locates;
+  uint64_t total_probe_len;
+  size_t max_probe_len;
+  uint64_t num_rehashes;
+  uint64_t rehash_ns;
+} KhmInstrument;
+
+static inline uint64_t khm_instrument_now_ns(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts)) return 0;
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static inline void khm_instrument_record_probe(KhmInstrument self[static 1], size_t probe_len) {
+  ++self->probe_histogram[probe_len < KHM_PROBE_HISTOGRAM_LEN ? probe_len : KHM_PROBE_HISTOGRAM_LEN - 1];
+  ++self->num_locates;
+  self->total_probe_len += probe_len;
+  if (probe_len > self->max_probe_len) self->max_probe_len = probe_len;
+}
+
+#endif
+#endif
+
 typedef struct {
   VecBool occupieds;
   VecU64 hashes;
@@ -40,22 +78,17 @@ typedef struct {
   KHM_VEC_V_T values;
   size_t len;
   size_t last_probe; // note: this would be useful if caller needs to strdup()
+#ifdef KHM_INSTRUMENT
+  KhmInstrument instrument;
+#endif
 } KHM_T;
 
-// KhmKV h = khmKV_new_cap(cap);
-static inline KHM_T KHM_F(new_cap)(size_t cap) {
+// sizes the empty vecs of ret to cap.
+static inline KHM_T KHM_F(new_cap_with_vecs)(size_t cap, KHM_T ret) {
   if (cap != (cap & -cap) || cap < 16) { // power of two of at least 16.
     fprintf(stderr, "invalid cap=%zu\n", cap);
     abort();
   }
-  KHM_T ret = {
-    .occupieds = vecBool_new(),
-    .hashes = vecU64_new(),
-    .keys = KHM_VEC_K_F(new)(),
-    .values = KHM_VEC_V_F(new)(),
-    .len = 0,
-    .last_probe = (size_t)-1,
-  };
   vecBool_ensure_cap_exact(&ret.occupieds, cap);
   vecU64_ensure_cap_exact(&ret.hashes, cap);
   KHM_VEC_K_F(ensure_cap_exact)(&ret.keys, cap);
@@ -68,6 +101,47 @@ static inline KHM_T KHM_F(new_cap)(size_t cap) {
   return ret;
 }
 
+#ifdef VEC_ALLOC_TAGGED
+
+// KhmKV h = khmKV_new_cap_tagged(cap, AllocTag_StatesFinder);
+// the tag goes to all the vecs, and stays with them across rehashes.
+static inline KHM_T KHM_F(new_cap_tagged)(size_t cap, AllocTag alloc_tag) {
+  return KHM_F(new_cap_with_vecs)(cap, (KHM_T){
+      .occupieds = vecBool_new_tagged(alloc_tag),
+      .hashes = vecU64_new_tagged(alloc_tag),
+      .keys = KHM_VEC_K_F(new_tagged)(alloc_tag),
+      .values = KHM_VEC_V_F(new_tagged)(alloc_tag),
+      .len = 0,
+      .last_probe = (size_t)-1,
+    });
+}
+
+// KhmKV h = khmKV_new_cap(cap);
+static inline KHM_T KHM_F(new_cap)(size_t cap) {
+  return KHM_F(new_cap_tagged)(cap, AllocTag_None);
+}
+
+// KhmKV h = khmKV_new_tagged(AllocTag_StatesFinder);
+static inline KHM_T KHM_F(new_tagged)(AllocTag alloc_tag) {
+  return KHM_F(new_cap_tagged)(16, alloc_tag);
+}
+
+#else
+
+// KhmKV h = khmKV_new_cap(cap);
+static inline KHM_T KHM_F(new_cap)(size_t cap) {
+  return KHM_F(new_cap_with_vecs)(cap, (KHM_T){
+      .occupieds = vecBool_new(),
+      .hashes = vecU64_new(),
+      .keys = KHM_VEC_K_F(new)(),
+      .values = KHM_VEC_V_F(new)(),
+      .len = 0,
+      .last_probe = (size_t)-1,
+    });
+}
+
+#endif
+
 // KhmKV h = khmKV_new();
 static inline KHM_T KHM_F(new)(void) {
   return KHM_F(new_cap)(16);
@@ -88,19 +162,35 @@ static inline size_t KHM_F(locate)(KHM_T self[static 1], KHM_K_T *pk, uint64_t h
   size_t mask = self->occupieds.len - 1; // always power of two.
   size_t bucket = hsh & mask;
   size_t probe = bucket;
+#ifdef KHM_INSTRUMENT
+#define KHM_RETURN_PROBE(ret) do { khm_instrument_record_probe(&self->instrument, (probe - bucket) & mask); return (ret); } while (0)
+#else
+#define KHM_RETURN_PROBE(ret) return (ret)
+#endif
   do {
-    if (!self->occupieds.ptr[probe]) return probe;
+    if (!self->occupieds.ptr[probe]) KHM_RETURN_PROBE(probe);
 #ifndef __clang__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
 #endif
-    if (self->hashes.ptr[probe] == hsh && KHM_K_EQLFUNC(&self->keys.ptr[probe], pk)) return probe;
+    if (self->hashes.ptr[probe] == hsh && KHM_K_EQLFUNC(&self->keys.ptr[probe], pk)) KHM_RETURN_PROBE(probe);
 #ifndef __clang__
 #pragma GCC diagnostic pop
 #endif
     probe = (probe + 1) & mask;
   } while (probe != bucket);
-  return (size_t)-1;
+  probe = (bucket - 1) & mask; // full, so every slot was looked at.
+  KHM_RETURN_PROBE((size_t)-1);
+#undef KHM_RETURN_PROBE
+}
+
+// returns the first free slot for hsh, for keys known to be absent (and a table with space).
+// not instrumented, so rehashes do not count as locates.
+static inline size_t KHM_F(locate_free)(KHM_T self[static 1], uint64_t hsh) {
+  size_t mask = self->occupieds.len - 1; // always power of two.
+  size_t probe = hsh & mask;
+  while (self->occupieds.ptr[probe]) probe = (probe + 1) & mask;
+  return probe;
 }
 
 // V *v = khmKV_get(&khm, &k);
@@ -119,6 +209,9 @@ static inline bool KHM_F(set)(KHM_T self[static 1], KHM_K_T *pk, KHM_V_T *pv) {
   size_t probe = self->len + self->len / 3 >= self->occupieds.len ? (size_t)-1 : KHM_F(locate)(self, pk, hsh);
   if (probe == (size_t)-1) {
     // no space. grow.
+#ifdef KHM_INSTRUMENT
+    uint64_t rehash_start_ns = khm_instrument_now_ns();
+#endif
     size_t next_cap = self->occupieds.len << 1; // ignore overflow.
     KHM_T old = *self;
     // rehash.
@@ -138,7 +231,8 @@ static inline bool KHM_F(set)(KHM_T self[static 1], KHM_K_T *pk, KHM_V_T *pv) {
     for (size_t i = 0; i < old.occupieds.len; ++i) {
       if (old.occupieds.ptr[i]) {
         uint64_t old_hash = old.hashes.ptr[i];
-        probe = KHM_F(locate)(self, old.keys.ptr + i, old_hash);
+        // keys are distinct, so this only needs a free slot.
+        probe = KHM_F(locate_free)(self, old_hash);
         self->occupieds.ptr[probe] = true;
         self->hashes.ptr[probe] = old_hash;
         memcpy(self->keys.ptr + probe, old.keys.ptr + i, sizeof(KHM_K_T));
@@ -146,6 +240,10 @@ static inline bool KHM_F(set)(KHM_T self[static 1], KHM_K_T *pk, KHM_V_T *pv) {
       }
     }
     KHM_F(free)(&old);
+#ifdef KHM_INSTRUMENT
+    ++self->instrument.num_rehashes;
+    self->instrument.rehash_ns += khm_instrument_now_ns() - rehash_start_ns;
+#endif
     probe = KHM_F(locate)(self, pk, hsh);
   }
   self->last_probe = probe;
@@ -161,6 +259,24 @@ static inline bool KHM_F(set)(KHM_T self[static 1], KHM_K_T *pk, KHM_V_T *pv) {
   return true; // inserted.
 }
 
+#ifdef KHM_INSTRUMENT
+// khmKV_fprint_instrument(stderr, &khm);
+static inline void KHM_F(fprint_instrument)(FILE *fp, KHM_T self[static 1]) {
+  KhmInstrument *instrument = &self->instrument;
+  fprintf(fp, "khm: len %zu, cap %zu, load factor %.3f\n",
+    self->len, self->occupieds.len, (double)self->len / (double)self->occupieds.len);
+  fprintf(fp, "khm: %" PRIu64 " locates, mean probe %.3f, max probe %zu\n",
+    instrument->num_locates, instrument->num_locates ? (double)instrument->total_probe_len / (double)instrument->num_locates : 0.0,
+    instrument->max_probe_len);
+  fprintf(fp, "khm: %" PRIu64 " rehashes taking %.6fs\n", instrument->num_rehashes, (double)instrument->rehash_ns / 1e9);
+  fputs("khm: probe length histogram:\n", fp);
+  for (size_t i = 0; i < KHM_PROBE_HISTOGRAM_LEN; ++i) {
+    if (!instrument->probe_histogram[i]) continue;
+    fprintf(fp, "  %s%2zu %" PRIu64 "\n", i == KHM_PROBE_HISTOGRAM_LEN - 1 ? ">=" : "  ", i, instrument->probe_histogram[i]);
+  }
+}
+#endif
+
 #undef KHM_VEC_V_F
 #undef KHM_VEC_V_T
 #undef KHM_VEC_K_F
@@ -7,6 +7,10 @@
 // undef VEC_ELT_T
 // undef VEC_ELT_NAME
 
+// needs realloc_or_die.
+// or define VEC_ALLOC_TAGGED (before including) to give every vec an AllocTag,
+// then it needs AllocTag (with AllocTag_None), realloc_tagged_or_die and free_tagged instead.
+
 #define GENERIC_CONCAT_(a, b) a##b
 #define GENERIC_CONCAT(a, b) GENERIC_CONCAT_(a, b)
 
@@ -16,8 +20,35 @@
 typedef struct {
   VEC_ELT_T *ptr;
   size_t len, cap;
+#ifdef VEC_ALLOC_TAGGED
+  AllocTag alloc_tag;
+#endif
 } VEC_T;
 
+#ifdef VEC_ALLOC_TAGGED
+
+// VecBool v = vecBool_new_tagged(AllocTag_States);
+static inline VEC_T VEC_F(new_tagged)(AllocTag alloc_tag) {
+  return (VEC_T){
+    .ptr = NULL,
+    .len = 0,
+    .cap = 0,
+    .alloc_tag = alloc_tag,
+  };
+}
+
+// VecBool v = vecBool_new();
+static inline VEC_T VEC_F(new)(void) {
+  return VEC_F(new_tagged)(AllocTag_None);
+}
+
+// ptr may be NULL with nonzero cap after the buffer has been moved out.
+#define VEC_HELD_BYTES(self) ((self)->ptr ? (self)->cap * sizeof(VEC_ELT_T) : 0)
+#define VEC_REALLOC(self, new_capacity) realloc_tagged_or_die((self)->alloc_tag, (self)->ptr, VEC_HELD_BYTES(self), (new_capacity) * sizeof(VEC_ELT_T))
+#define VEC_FREE(self) free_tagged((self)->alloc_tag, (self)->ptr, VEC_HELD_BYTES(self))
+
+#else
+
 // VecBool v = vecBool_new();
 static inline VEC_T VEC_F(new)(void) {
   return (VEC_T){
@@ -27,10 +58,15 @@ static inline VEC_T VEC_F(new)(void) {
   };
 }
 
+#define VEC_REALLOC(self, new_capacity) realloc_or_die((self)->ptr, (new_capacity) * sizeof(VEC_ELT_T))
+#define VEC_FREE(self) free((self)->ptr)
+
+#endif
+
 // vecBool_ensure_cap_exact(&vec, new_cap);
 static inline void VEC_F(ensure_cap_exact)(VEC_T self[static 1], size_t new_capacity) {
   if (self->cap < new_capacity) {
-    self->ptr = realloc_or_die(self->ptr, new_capacity * sizeof(VEC_ELT_T));
+    self->ptr = VEC_REALLOC(self, new_capacity);
     self->cap = new_capacity;
   }
 }
@@ -39,14 +75,14 @@ static inline void VEC_F(ensure_cap_exact)(VEC_T self[static 1], size_t new_capa
 static inline void VEC_F(ensure_cap)(VEC_T self[static 1], size_t min_capacity) {
   if (self->cap < min_capacity) {
     size_t new_capacity = min_capacity << 1; // assume no overflow.
-    self->ptr = realloc_or_die(self->ptr, new_capacity * sizeof(VEC_ELT_T));
+    self->ptr = VEC_REALLOC(self, new_capacity);
     self->cap = new_capacity;
   }
 }
 
 // vecBool_free(&vec);
 static inline void VEC_F(free)(VEC_T self[static 1]) {
-  free(self->ptr);
+  VEC_FREE(self);
   self->ptr = NULL;
   self->len = 0;
   self->cap = 0;
@@ -59,5 +95,10 @@ static inline void VEC_F(push)(VEC_T self[static 1], VEC_ELT_T *elt) {
   ++self->len;
 }
 
+#undef VEC_FREE
+#undef VEC_REALLOC
+#ifdef VEC_ALLOC_TAGGED
+#undef VEC_HELD_BYTES
+#endif
 #undef VEC_F
 #undef VEC_T
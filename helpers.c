@@ -0,0 +1,141 @@
+// Copyright (C) 2020-2025 Andy Kurnia.
+
+// time, random and perf helpers, shared by kwgc and the benchmarks.
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+// time helpers
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts)) return 0;
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// random helpers
+
+// splitmix64, deterministic, good enough and the same everywhere.
+static inline uint64_t rng_next(uint64_t state[static 1]) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+static inline uint32_t rng_below(uint64_t state[static 1], uint32_t n) {
+  return (uint32_t)(((rng_next(state) >> 32) * n) >> 32);
+}
+
+// perf helpers
+
+typedef enum {
+    PerfCounter_Cycles,
+    PerfCounter_Instructions,
+    PerfCounter_L1dMisses,
+    PerfCounter_LlcMisses,
+    PerfCounter_DtlbMisses,
+    PerfCounter_BranchMisses,
+    PerfCounter_Count,
+} PerfCounter;
+
+const char *perf_counter_names[PerfCounter_Count] = {
+  "cycles",
+  "instructions",
+  "l1d_misses",
+  "llc_misses",
+  "dtlb_misses",
+  "branch_misses",
+};
+
+// the counters are opened as one group, so they count over the same time and ratios like ipc hold.
+// fds[i] < 0 if that counter could not be opened (no permission, no pmu, not linux).
+typedef struct {
+  int leader; // the first fd opened, < 0 if none.
+  int fds[PerfCounter_Count];
+  // raw values at the previous read, these never go backwards.
+  uint64_t last[PerfCounter_Count];
+  uint64_t last_enabled;
+  uint64_t last_running;
+} PerfGroup;
+
+#ifdef __linux__
+#define PERF_HW_CACHE_READ_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+#endif
+
+// opens what it can, reports what it cannot. counts this thread and threads it creates later.
+PerfGroup perf_group_open(void) {
+  PerfGroup ret = { .leader = -1 };
+  for (int i = 0; i < PerfCounter_Count; ++i) ret.fds[i] = -1;
+#ifdef __linux__
+  static const struct { uint32_t type; uint64_t config; } perf_configs[PerfCounter_Count] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_HW_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+    { PERF_TYPE_HW_CACHE, PERF_HW_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) },
+    { PERF_TYPE_HW_CACHE, PERF_HW_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  };
+  uint32_t inherit = 1;
+  for (int i = 0; i < PerfCounter_Count; ++i) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perf_configs[i].type;
+    attr.config = perf_configs[i].config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = inherit;
+    ret.fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, ret.leader, 0);
+    if (ret.fds[i] < 0 && ret.leader < 0 && inherit && errno == EINVAL) {
+      // older kernels cannot read an inherited group.
+      attr.inherit = inherit = 0;
+      ret.fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      if (ret.fds[i] >= 0) fputs("perf: only counting the main thread\n", stderr);
+    }
+    if (ret.fds[i] < 0) fprintf(stderr, "perf: %s unavailable: %s\n", perf_counter_names[i], strerror(errno));
+    else if (ret.leader < 0) ret.leader = ret.fds[i];
+  }
+#else
+  fputs("perf: unavailable on this platform\n", stderr);
+#endif
+  return ret;
+}
+
+// adds the counts since the previous read to deltas.
+// each delta is scaled up by its own share of running time if the kernel had to multiplex the group.
+void perf_group_read_deltas(PerfGroup self[static 1], uint64_t deltas[static PerfCounter_Count]) {
+  uint64_t values[3 + PerfCounter_Count]; // number of counters, time enabled, time running, then each open counter.
+  if (self->leader < 0) return;
+  ssize_t len = read(self->leader, values, sizeof(values));
+  if (len < (ssize_t)(3 * sizeof(uint64_t))) return;
+  uint64_t delta_enabled = values[1] - self->last_enabled;
+  uint64_t delta_running = values[2] - self->last_running;
+  self->last_enabled = values[1];
+  self->last_running = values[2];
+  uint64_t k = 3;
+  for (int i = 0; i < PerfCounter_Count && k < 3 + values[0]; ++i) {
+    if (self->fds[i] < 0) continue;
+    uint64_t delta = values[k] - self->last[i];
+    self->last[i] = values[k++];
+    if (delta_running && delta_running < delta_enabled) delta = (uint64_t)((double)delta * ((double)delta_enabled / (double)delta_running));
+    deltas[i] += delta;
+  }
+}
+
+void perf_group_close(PerfGroup self[static 1]) {
+  for (int i = PerfCounter_Count; i-- > 0; ) {
+    if (self->fds[i] >= 0) close(self->fds[i]);
+    self->fds[i] = -1;
+  }
+  self->leader = -1;
+}
@@ -6,14 +6,15 @@
 #include <stdint.h>
 #include <sys/mman.h>
 
-typedef struct { uint8_t c : 6; bool e : 1, d : 1; uint32_t p : 24; } KbwgNode; // compiler-specific UB.
+#include "nodes.c"
 
-void dump_kbwg(KbwgNode *kbwg, char s[static 1], size_t l, uint32_t p) {
+void dump_kbwg(const uint32_t *kbwg, char s[static 1], size_t l, uint32_t p) {
   for (; p > 0; ++p) {
-    s[l] = (char)(kbwg[p].c | 0x40); // english only.
-    if (kbwg[p].d) printf("%.*s\n", (int)(l + 1), s);
-    if (kbwg[p].p) dump_kbwg(kbwg, s, l + 1, kbwg[p].p);
-    if (kbwg[p].e) break;
+    uint32_t node = node_at(kbwg, p);
+    s[l] = (char)(kbwg_node_c(node) | 0x40); // english only.
+    if (kbwg_node_d(node)) printf("%.*s\n", (int)(l + 1), s);
+    if (kbwg_node_p(node)) dump_kbwg(kbwg, s, l + 1, kbwg_node_p(node));
+    if (kbwg_node_e(node)) break;
   }
 }
 
@@ -30,10 +31,10 @@ int main(int argc, char **argv) {
   off_t kbwg_size_signed = ftello(f); if (kbwg_size_signed < 0) { perror("ftello"); goto errored; }
   size_t kbwg_size = (size_t)kbwg_size_signed;
   if ((kbwg_size & 3) != 0 || !((size_t)dawgroot < (kbwg_size >> 2))) { fputs("unexpected file size\n", stderr); goto errored; }
-  KbwgNode *kbwg = mmap(NULL, kbwg_size, PROT_READ, MAP_SHARED, fileno(f), 0); if (!kbwg) { perror("mmap"); goto errored; } defer_munmap = true;
+  uint32_t *kbwg = mmap(NULL, kbwg_size, PROT_READ, MAP_SHARED, fileno(f), 0); if (kbwg == MAP_FAILED) { perror("mmap"); goto errored; } defer_munmap = true;
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
   char buf[64]; // risky!
-  dump_kbwg(kbwg, buf, 0, kbwg[dawgroot].p);
+  dump_kbwg(kbwg, buf, 0, kbwg_node_p(node_at(kbwg, (uint32_t)dawgroot)));
   goto cleanup;
 errored: errored = true;
 cleanup:
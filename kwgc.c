@@ -1,13 +1,20 @@
 // Copyright (C) 2020-2025 Andy Kurnia.
 
 #include <arpa/inet.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 
 typedef enum {
     BuildLayout_Legacy,
@@ -15,6 +22,9 @@ typedef enum {
     BuildLayout_MagpieMerged,
     BuildLayout_Experimental,
     BuildLayout_Wolges,
+    BuildLayout_Profiled,
+    BuildLayout_Paged,
+    BuildLayout_Hot,
 } BuildLayout;
 
 // endian helpers
@@ -23,14 +33,6 @@ bool is_big_endian(void) {
   return htons(1) == 1;
 }
 
-void swap_bytes_32(uint8_t *p, size_t size_in_bytes) {
-  uint8_t t;
-  for (size_t i = 3; i < size_in_bytes; i += 4) {
-    t = p[i], p[i] = p[i - 3], p[i - 3] = t;
-    t = p[i - 1], p[i - 1] = p[i - 2], p[i - 2] = t;
-  }
-}
-
 // time helpers
 
 bool time_goes_to_stderr = false;
@@ -54,6 +56,296 @@ int fprint_dur_us(FILE *fp, struct timeval tv_end, struct timeval tv_start) {
   return fprintf(fp, "%" PRId64 ".%06d", dur_sec, dur_usec);
 }
 
+// stats helpers
+
+// where the time goes, in pipeline order.
+typedef enum {
+    Phase_Read,
+    Phase_Verify,
+    Phase_Tokenize,
+    Phase_Sort,
+    Phase_Dedup,
+    Phase_DawgMinimize,
+    Phase_GaddagExpand,
+    Phase_GaddagSort,
+    Phase_GaddagMinimize,
+    Phase_LayoutPasses,
+    Phase_Defrag,
+    Phase_Emit,
+    Phase_Dump,
+    Phase_Analyze,
+    Phase_Write,
+    Phase_Count,
+} Phase;
+
+const char *phase_names[Phase_Count] = {
+  "read",
+  "verify",
+  "tokenize",
+  "sort",
+  "dedup",
+  "dawg_minimize",
+  "gaddag_expand",
+  "gaddag_sort",
+  "gaddag_minimize",
+  "layout_passes", // head_indexes, to_end_lens, num_ways, top_indexes.
+  "defrag",
+  "emit",
+  "dump",
+  "analyze",
+  "write",
+};
+
+typedef enum {
+    StatsFormat_None,
+    StatsFormat_Text,
+    StatsFormat_Json,
+} StatsFormat;
+
+typedef struct {
+  uint64_t phase_ns[Phase_Count];
+  uint32_t phase_runs[Phase_Count];
+  uint64_t states_created;
+  uint64_t hash_lookups;
+  uint64_t hash_hits;
+  uint64_t rehashes;
+  uint64_t states; // including the sink state.
+  uint64_t nodes_written; // including gaps.
+  uint64_t gap_nodes; // slots left empty by the layout.
+  size_t phase_peak_alloc_bytes[Phase_Count];
+  uint64_t phase_peak_rss_kib[Phase_Count]; // only with --stats.
+} Stats;
+
+// named structures whose memory is accounted for.
+// AllocTag_None is not accounted, so it is safe to use from other threads.
+typedef enum {
+    AllocTag_None,
+    AllocTag_FileContent,
+    AllocTag_Words,
+    AllocTag_GaddagWords,
+    AllocTag_TransitionStack,
+    AllocTag_States,
+    AllocTag_StatesFinder,
+    AllocTag_HeadIndexes,
+    AllocTag_ToEndLens,
+    AllocTag_Destination,
+    AllocTag_NumWays,
+    AllocTag_TopIndexes,
+    AllocTag_Profile, // profile words, weights, heats.
+    AllocTag_DefragScratch, // idxs, used_in_dawg, block bins.
+    AllocTag_Output,
+    AllocTag_Sidecar, // jump table.
+    AllocTag_Count,
+} AllocTag;
+
+const char *alloc_tag_names[AllocTag_Count] = {
+  "none",
+  "file_content",
+  "words",
+  "gaddag_words",
+  "transition_stack",
+  "states",
+  "states_finder",
+  "head_indexes",
+  "to_end_lens",
+  "destination",
+  "num_ways",
+  "top_indexes",
+  "profile",
+  "defrag_scratch",
+  "output",
+  "sidecar",
+};
+
+typedef struct {
+  size_t bytes; // currently held.
+  size_t peak_bytes;
+  uint64_t allocs;
+  uint64_t reallocs;
+  uint64_t bytes_copied; // by reallocs that moved.
+} AllocStats;
+
+AllocStats alloc_stats[AllocTag_Count];
+size_t alloc_bytes; // sum over all tags.
+size_t alloc_phase_peak_bytes; // since the previous stats_end_phase.
+
+Stats stats; // always collected, only printed with --stats.
+StatsFormat stats_format = StatsFormat_None;
+uint64_t stats_phase_start_ns;
+
+#include "helpers.c"
+
+// set if the peak cannot be reset, each phase then sees the peak so far.
+bool peak_rss_is_cumulative = false;
+
+// peak resident set size in KiB since the last reset_peak_rss.
+uint64_t read_peak_rss_kib(void) {
+  uint64_t ret = 0;
+  FILE *f = fopen("/proc/self/status", "r");
+  if (f) {
+    char line[256];
+    while (fgets(line, sizeof(line), f)) if (sscanf(line, "VmHWM: %" SCNu64, &ret) == 1) break;
+    fclose(f);
+  }
+  if (!ret) {
+    struct rusage usage;
+    if (!getrusage(RUSAGE_SELF, &usage)) ret = (uint64_t)usage.ru_maxrss; // KiB on linux.
+    peak_rss_is_cumulative = true;
+  }
+  return ret;
+}
+
+// linux resets VmHWM to the current rss on writing 5 to clear_refs.
+void reset_peak_rss(void) {
+  if (peak_rss_is_cumulative) return;
+  FILE *f = fopen("/proc/self/clear_refs", "w");
+  if (!f) { peak_rss_is_cumulative = true; return; }
+  if (fputs("5", f) < 0) peak_rss_is_cumulative = true;
+  if (fclose(f)) peak_rss_is_cumulative = true;
+}
+
+// perf helpers
+
+typedef struct {
+  bool enabled;
+  PerfGroup group;
+  uint64_t phase_counts[Phase_Count][PerfCounter_Count];
+} Perf;
+
+Perf perf = { .enabled = false };
+
+void perf_open(void) {
+  perf.enabled = true;
+  perf.group = perf_group_open();
+}
+
+void perf_end_phase(Phase phase) {
+  perf_group_read_deltas(&perf.group, perf.phase_counts[phase]);
+}
+
+void perf_close(void) {
+  perf_group_close(&perf.group);
+}
+
+// attributes the time since the previous stats_end_phase (or main) to phase.
+static inline void stats_end_phase(Phase phase) {
+  uint64_t t = now_ns();
+  stats.phase_ns[phase] += t - stats_phase_start_ns;
+  ++stats.phase_runs[phase];
+  stats_phase_start_ns = t;
+  if (alloc_phase_peak_bytes > stats.phase_peak_alloc_bytes[phase]) stats.phase_peak_alloc_bytes[phase] = alloc_phase_peak_bytes;
+  alloc_phase_peak_bytes = alloc_bytes;
+  if (stats_format != StatsFormat_None) {
+    uint64_t peak_rss_kib = read_peak_rss_kib();
+    if (peak_rss_kib > stats.phase_peak_rss_kib[phase]) stats.phase_peak_rss_kib[phase] = peak_rss_kib;
+    reset_peak_rss();
+  }
+  if (perf.enabled) perf_end_phase(phase);
+}
+
+void fprint_perf(FILE *fp) {
+  if (perf.group.leader < 0) return; // perf_open already said why.
+  fprintf(fp, "%-18s", "perf");
+  for (int j = 0; j < PerfCounter_Count; ++j) fprintf(fp, " %14s", perf_counter_names[j]);
+  fputs("    ipc\n", fp);
+  for (int i = 0; i < Phase_Count; ++i) {
+    if (!stats.phase_runs[i]) continue;
+    fprintf(fp, "  %-16s", phase_names[i]);
+    for (int j = 0; j < PerfCounter_Count; ++j) {
+      if (perf.group.fds[j] < 0) fprintf(fp, " %14s", "-"); else fprintf(fp, " %14" PRIu64, perf.phase_counts[i][j]);
+    }
+    uint64_t cycles = perf.phase_counts[i][PerfCounter_Cycles];
+    if (cycles) fprintf(fp, " %6.3f", (double)perf.phase_counts[i][PerfCounter_Instructions] / (double)cycles);
+    fputc('\n', fp);
+  }
+}
+
+void fprint_stats(FILE *fp, uint64_t total_ns) {
+  if (stats_format == StatsFormat_Json) {
+    fputs("{\"phase_seconds\":{", fp);
+    bool is_first = true;
+    for (int i = 0; i < Phase_Count; ++i) {
+      if (!stats.phase_runs[i]) continue;
+      fprintf(fp, "%s\"%s\":%.9f", is_first ? "" : ",", phase_names[i], (double)stats.phase_ns[i] / 1e9);
+      is_first = false;
+    }
+    fputs("},\"phase_peak_rss_kib\":{", fp);
+    is_first = true;
+    for (int i = 0; i < Phase_Count; ++i) {
+      if (!stats.phase_runs[i]) continue;
+      fprintf(fp, "%s\"%s\":%" PRIu64, is_first ? "" : ",", phase_names[i], stats.phase_peak_rss_kib[i]);
+      is_first = false;
+    }
+    fprintf(fp, "},\"peak_rss_is_cumulative\":%s,\"phase_peak_alloc_bytes\":{", peak_rss_is_cumulative ? "true" : "false");
+    is_first = true;
+    for (int i = 0; i < Phase_Count; ++i) {
+      if (!stats.phase_runs[i]) continue;
+      fprintf(fp, "%s\"%s\":%zu", is_first ? "" : ",", phase_names[i], stats.phase_peak_alloc_bytes[i]);
+      is_first = false;
+    }
+    fputs("},\"allocs\":{", fp);
+    is_first = true;
+    for (int i = AllocTag_None + 1; i < AllocTag_Count; ++i) {
+      AllocStats *a = &alloc_stats[i];
+      if (!a->allocs) continue;
+      fprintf(fp, "%s\"%s\":{\"bytes\":%zu,\"peak_bytes\":%zu,\"allocs\":%" PRIu64 ",\"reallocs\":%" PRIu64 ",\"bytes_copied\":%" PRIu64 "}",
+        is_first ? "" : ",", alloc_tag_names[i], a->bytes, a->peak_bytes, a->allocs, a->reallocs, a->bytes_copied);
+      is_first = false;
+    }
+    fprintf(fp, "},\"total_seconds\":%.9f", (double)total_ns / 1e9);
+    fprintf(fp, ",\"states_created\":%" PRIu64 ",\"hash_lookups\":%" PRIu64 ",\"hash_hits\":%" PRIu64 ",\"rehashes\":%" PRIu64,
+      stats.states_created, stats.hash_lookups, stats.hash_hits, stats.rehashes);
+    fprintf(fp, ",\"states\":%" PRIu64 ",\"nodes_written\":%" PRIu64 ",\"gap_nodes\":%" PRIu64, stats.states, stats.nodes_written, stats.gap_nodes);
+    if (perf.enabled) {
+      // unavailable counters are left out.
+      fputs(",\"perf\":{", fp);
+      is_first = true;
+      for (int i = 0; i < Phase_Count; ++i) {
+        if (!stats.phase_runs[i]) continue;
+        fprintf(fp, "%s\"%s\":{", is_first ? "" : ",", phase_names[i]);
+        bool is_first_counter = true;
+        for (int j = 0; j < PerfCounter_Count; ++j) {
+          if (perf.group.fds[j] < 0) continue;
+          fprintf(fp, "%s\"%s\":%" PRIu64, is_first_counter ? "" : ",", perf_counter_names[j], perf.phase_counts[i][j]);
+          is_first_counter = false;
+        }
+        fputc('}', fp);
+        is_first = false;
+      }
+      fputc('}', fp);
+    }
+    fputs("}\n", fp);
+  } else {
+    for (int i = 0; i < Phase_Count; ++i) {
+      if (!stats.phase_runs[i]) continue;
+      fprintf(fp, "  %-16s %.6fs  peak rss %9" PRIu64 " KiB  peak accounted %9zu KiB\n", phase_names[i], (double)stats.phase_ns[i] / 1e9,
+        stats.phase_peak_rss_kib[i], (stats.phase_peak_alloc_bytes[i] + 1023) >> 10);
+    }
+    if (peak_rss_is_cumulative) fputs("(peak rss cannot be reset, so it is the peak so far)\n", fp);
+    bool has_allocs = false;
+    for (int i = AllocTag_None + 1; i < AllocTag_Count; ++i) has_allocs |= alloc_stats[i].allocs > 0;
+    if (has_allocs) {
+      fprintf(fp, "%-18s %12s %12s %8s %8s %12s\n", "memory", "held", "peak", "allocs", "reallocs", "copied");
+      for (int i = AllocTag_None + 1; i < AllocTag_Count; ++i) {
+        AllocStats *a = &alloc_stats[i];
+        if (!a->allocs) continue;
+        fprintf(fp, "  %-16s %12zu %12zu %8" PRIu64 " %8" PRIu64 " %12" PRIu64 "\n",
+          alloc_tag_names[i], a->bytes, a->peak_bytes, a->allocs, a->reallocs, a->bytes_copied);
+      }
+    }
+    if (stats.hash_lookups) {
+      fprintf(fp, "states created: %" PRIu64 "\n", stats.states_created);
+      fprintf(fp, "hash lookups: %" PRIu64 " (%" PRIu64 " hits), rehashes: %" PRIu64 "\n", stats.hash_lookups, stats.hash_hits, stats.rehashes);
+    }
+    if (stats.states) {
+      fprintf(fp, "states: %" PRIu64 ", nodes written: %" PRIu64 " (%.3f per state), wasted slots: %" PRIu64 " (%.3f%%)\n",
+        stats.states, stats.nodes_written, (double)stats.nodes_written / (double)stats.states,
+        stats.gap_nodes, stats.nodes_written ? 100.0 * (double)stats.gap_nodes / (double)stats.nodes_written : 0.0);
+    }
+    if (perf.enabled) fprint_perf(fp);
+  }
+}
+
 // malloc helpers
 
 static inline void *not_null_or_die(void *ptr) {
@@ -69,8 +361,84 @@ static inline void *realloc_or_die(void *ptr, size_t size) {
   return not_null_or_die(realloc(ptr, size));
 }
 
+// the tagged variants also account for the memory under the tag.
+// sizes are what the caller asked for, not what malloc rounded up to.
+
+static inline void alloc_note(AllocTag tag, size_t old_size, size_t new_size, bool moved) {
+  if (tag == AllocTag_None) return;
+  AllocStats *a = &alloc_stats[tag];
+  if (!old_size) {
+    ++a->allocs;
+  } else if (new_size) {
+    ++a->reallocs;
+    if (moved) a->bytes_copied += old_size;
+  }
+  a->bytes = a->bytes - old_size + new_size;
+  if (a->bytes > a->peak_bytes) a->peak_bytes = a->bytes;
+  alloc_bytes = alloc_bytes - old_size + new_size;
+  if (alloc_bytes > alloc_phase_peak_bytes) alloc_phase_peak_bytes = alloc_bytes;
+}
+
+static inline void *malloc_tagged_or_die(AllocTag tag, size_t size) {
+  void *ret = malloc_or_die(size);
+  alloc_note(tag, 0, size, false);
+  return ret;
+}
+
+// old_size must be 0 if ptr is NULL.
+static inline void *realloc_tagged_or_die(AllocTag tag, void *ptr, size_t old_size, size_t size) {
+  // only the address is compared, the old memory is not touched.
+#ifndef __clang__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuse-after-free"
+#endif
+  uintptr_t old_address = (uintptr_t)ptr;
+  void *ret = realloc_or_die(ptr, size);
+  alloc_note(tag, old_size, size, (uintptr_t)ret != old_address);
+#ifndef __clang__
+#pragma GCC diagnostic pop
+#endif
+  return ret;
+}
+
+static inline void free_tagged(AllocTag tag, void *ptr, size_t size) {
+  if (!ptr) return;
+  free(ptr);
+  alloc_note(tag, size, 0, false);
+}
+
+// mmap helpers
+
+#ifndef MAP_POPULATE
+#define MAP_POPULATE 0
+#endif
+
+// maps the whole file for reading, returns NULL (after reporting) on error.
+// the file size must be a nonzero multiple of 4.
+uint8_t *mmap_file_or_null(const char path[static 1], size_t file_size[static 1]) {
+  uint8_t *ret = NULL;
+  FILE *f = fopen(path, "rb"); if (!f) { perror("fopen"); return NULL; }
+  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto cleanup; }
+  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto cleanup; }
+  *file_size = (size_t)file_size_signed;
+  if (!*file_size || (*file_size & 3) != 0) { fputs("unexpected file size\n", stderr); goto cleanup; }
+  void *mapped = mmap(NULL, *file_size, PROT_READ, MAP_SHARED | MAP_POPULATE, fileno(f), 0);
+  if (mapped == MAP_FAILED) { perror("mmap"); goto cleanup; }
+  ret = mapped;
+  if (madvise(ret, *file_size, MADV_WILLNEED)) perror("madvise"); // only a hint.
+cleanup:
+  if (fclose(f)) {
+    perror("fclose");
+    if (ret && munmap(ret, *file_size)) perror("munmap");
+    ret = NULL;
+  }
+  return ret;
+}
+
 // generic vec types
 
+#define VEC_ALLOC_TAGGED // every vec carries an AllocTag for the accounting above.
+
 #define VEC_ELT_NAME Bool
 #define VEC_ELT_T bool
 #include "generic_vec.c"
@@ -105,6 +473,16 @@ static inline void *realloc_or_die(void *ptr, size_t size) {
 
 #include "tiles.c"
 
+// node accessors
+
+#include "nodes.c"
+
+// either format, for the code that handles both.
+static inline uint32_t layout_node_p(uint32_t node, bool is_kbwg) { return is_kbwg ? kbwg_node_p(node) : kwg_node_p(node); }
+static inline bool layout_node_e(uint32_t node, bool is_kbwg) { return is_kbwg ? kbwg_node_e(node) : kwg_node_e(node); }
+static inline bool layout_node_d(uint32_t node, bool is_kbwg) { return is_kbwg ? kbwg_node_d(node) : kwg_node_d(node); }
+static inline uint8_t layout_node_c(uint32_t node, bool is_kbwg) { return is_kbwg ? kbwg_node_c(node) : kwg_node_c(node); }
+
 // parser
 
 typedef struct {
@@ -147,10 +525,10 @@ typedef struct {
   VecByte tiles_bytes;
 } Wordlist;
 
-static inline Wordlist wordlist_new(void) {
+static inline Wordlist wordlist_new(AllocTag alloc_tag) {
   return (Wordlist){
-      .tiles_slices = vecOfsLen_new(),
-      .tiles_bytes = vecByte_new(),
+      .tiles_slices = vecOfsLen_new_tagged(alloc_tag),
+      .tiles_bytes = vecByte_new_tagged(alloc_tag),
     };
 }
 
@@ -180,6 +558,26 @@ static inline void wordlist_dedup(Wordlist self[static 1]) {
   }
 }
 
+// access profile, for the profiled layout.
+// words[i] was looked up weights.ptr[i] times.
+
+typedef struct {
+  Wordlist words;
+  VecU64 weights;
+} LayoutProfile;
+
+static inline LayoutProfile layout_profile_new(void) {
+  return (LayoutProfile){
+      .words = wordlist_new(AllocTag_Profile),
+      .weights = vecU64_new_tagged(AllocTag_Profile),
+    };
+}
+
+static inline void layout_profile_free(LayoutProfile self[static 1]) {
+  vecU64_free(&self->weights);
+  wordlist_free(&self->words);
+}
+
 // kwg builder
 
 // unconfirmed entries.
@@ -202,8 +600,8 @@ typedef struct {
 
 static inline KwgcTransitionStack kwgc_transition_stack_new(void) {
   return (KwgcTransitionStack){
-    .transitions = vecKwgcTransition_new(),
-    .indexes = vecU32_new(),
+    .transitions = vecKwgcTransition_new_tagged(AllocTag_TransitionStack),
+    .indexes = vecU32_new_tagged(AllocTag_TransitionStack),
   };
 }
 
@@ -222,65 +620,7 @@ static inline void kwgc_transition_stack_push(KwgcTransitionStack self[static 1]
   vecU32_push(&self->indexes, &len);
 }
 
-typedef struct {
-  uint32_t arc_index; // refers to states.
-  uint32_t next_index; // refers to states.
-  uint8_t tile;
-  bool accepts;
-} KwgcState;
-
-#define VEC_ELT_NAME KwgcState
-#define VEC_ELT_T KwgcState
-#include "generic_vec.c"
-#undef VEC_ELT_T
-#undef VEC_ELT_NAME
-
-static inline void do_hash(uint64_t *hash, uint8_t data) {
-  *hash = (*hash * 3467) ^ (data ^ 0xff);
-}
-
-static inline uint64_t kwgc_state_hash(KwgcState self[static 1]) {
-  uint64_t hash = 0;
-  do_hash(&hash, self->tile);
-  do_hash(&hash, self->accepts);
-  do_hash(&hash, ((uint8_t *)&self->arc_index)[0]);
-  do_hash(&hash, ((uint8_t *)&self->arc_index)[1]);
-  do_hash(&hash, ((uint8_t *)&self->arc_index)[2]);
-  do_hash(&hash, ((uint8_t *)&self->arc_index)[3]);
-  do_hash(&hash, ((uint8_t *)&self->next_index)[0]);
-  do_hash(&hash, ((uint8_t *)&self->next_index)[1]);
-  do_hash(&hash, ((uint8_t *)&self->next_index)[2]);
-  do_hash(&hash, ((uint8_t *)&self->next_index)[3]);
-  return hash;
-}
-
-static inline bool kwgc_state_eql(KwgcState a[static 1], KwgcState b[static 1]) {
-#ifndef __clang__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif
-  return a->tile == b->tile &&
-    a->accepts == b->accepts &&
-    a->arc_index == b->arc_index &&
-    a->next_index == b->next_index;
-#ifndef __clang__
-#pragma GCC diagnostic pop
-#endif
-}
-
-#define KHM_K_NAME KwgcState
-#define KHM_K_T KwgcState
-#define KHM_K_HASHFUNC kwgc_state_hash
-#define KHM_K_EQLFUNC kwgc_state_eql
-#define KHM_V_NAME U32
-#define KHM_V_T uint32_t
-#include "generic_khm.c"
-#undef KHM_V_T
-#undef KHM_V_NAME
-#undef KHM_K_EQLFUNC
-#undef KHM_K_HASHFUNC
-#undef KHM_K_T
-#undef KHM_K_NAME
+#include "kwgc_state.c"
 
 // for each i > 0, states[i].arc_index < i and states[i].next_index < i.
 // this ensures states is already a topologically sorted DAG.
@@ -291,8 +631,8 @@ typedef struct {
 
 static inline KwgcStateMaker kwgc_state_maker_new(void) {
   return (KwgcStateMaker){
-      .states = vecKwgcState_new(),
-      .states_finder = khmKwgcStateU32_new(),
+      .states = vecKwgcState_new_tagged(AllocTag_States),
+      .states_finder = khmKwgcStateU32_new_tagged(AllocTag_StatesFinder),
     };
 }
 
@@ -312,12 +652,17 @@ static inline uint32_t kwgc_state_maker_make_state(KwgcStateMaker self[static 1]
         .accepts = node_transition->accepts,
       };
     uint32_t *existing_state_index = khmKwgcStateU32_get(&self->states_finder, &state);
+    ++stats.hash_lookups;
     if (existing_state_index) {
       ret = *existing_state_index;
+      ++stats.hash_hits;
     } else {
       ret = (uint32_t)self->states.len;
       vecKwgcState_push(&self->states, &state);
+      size_t old_cap = self->states_finder.occupieds.len;
       khmKwgcStateU32_set(&self->states_finder, &state, &ret);
+      ++stats.states_created;
+      stats.rehashes += self->states_finder.occupieds.len != old_cap;
     }
   }
   return ret;
@@ -455,72 +800,138 @@ void kwgc_states_defragger_defrag_magpie_merged(KwgcStatesDefragger self[static
   // non-legacy mode already reserves the space.
 }
 
-// Each block has 16 entries (hardcoded).
+// Each block has 1 << block_shift entries, 16 by default (see --block).
 // 16 entries of u32 make 64 bytes, which is a common cache line size.
-// 0 <= block_len[i] <= 16, from (i << 4) the first block_len[i] are occupied.
-// If block_len[i] < 16, blocks_with_len[block_len[i]] stack includes i.
+// 0 <= block_len[i] <= block size, from (i << block_shift) the first block_len[i] are occupied.
+// If block_len[i] < block size, blocks_with_len[block_len[i]] stack includes i.
+#define MAX_BLOCK_SHIFT 5
 typedef struct {
   VecByte block_len;
-  VecU32 blocks_with_len[16];
+  VecU32 blocks_with_len[1 << MAX_BLOCK_SHIFT];
+  uint8_t block_shift;
+  uint32_t align_blocks; // lists longer than a block start at a multiple of this many blocks.
 } KwgcStatesDefraggerExperimentalParams;
 
-static inline void kwgc_states_defragger_defrag_cache_friendly(KwgcStatesDefragger self[static 1], KwgcStatesDefraggerExperimentalParams params[static 1], uint32_t p) {
-  p = self->head_indexes[p];
-  uint32_t *dp = self->destination + p;
-  if (*dp) return;
-  // temp value to break self-cycles.
-  *dp = (uint32_t)~0;
-  // non-legacy mode reserves the space first.
-  uint32_t num = self->to_end_lens[p];
+// block geometry for the experimental, wolges, paged, profiled and hot layouts, set by --block and --align.
+uint8_t layout_block_shift = 4;
+uint8_t layout_align_shift = 5; // even-align for 128 byte cache line machines.
+
+// the hot layout's prefix, set by --hot-depth and --hot-top.
+uint32_t layout_hot_depth = 2; // sibling lists this close to a root.
+uint32_t layout_hot_top = 0; // and this many most reached sibling lists.
+
+// num_written is the number of root nodes already at the start.
+static inline KwgcStatesDefraggerExperimentalParams kwgc_states_defragger_experimental_params_new(uint32_t num_written) {
+  KwgcStatesDefraggerExperimentalParams ret = {
+      .block_len = vecByte_new_tagged(AllocTag_DefragScratch),
+      .block_shift = layout_block_shift,
+      .align_blocks = layout_align_shift > layout_block_shift ? (uint32_t)1 << (layout_align_shift - layout_block_shift) : 1,
+    };
+  for (uint32_t i = 0; i < (uint32_t)1 << MAX_BLOCK_SHIFT; ++i) ret.blocks_with_len[i] = vecU32_new_tagged(AllocTag_DefragScratch);
+  {
+    // num_written is either 1 or 2, both are < 8.
+    uint8_t num_written_as_byte = (uint8_t)num_written;
+    vecByte_push(&ret.block_len, &num_written_as_byte);
+  }
+  {
+    uint32_t zero = 0;
+    vecU32_push(&ret.blocks_with_len[num_written], &zero);
+  }
+  return ret;
+}
+
+// a fresh page has no root nodes, so it starts without blocks and the first longer list is aligned at its start.
+static inline KwgcStatesDefraggerExperimentalParams kwgc_states_defragger_experimental_params_new_page(void) {
+  KwgcStatesDefraggerExperimentalParams ret = kwgc_states_defragger_experimental_params_new(0);
+  ret.block_len.len = 0;
+  ret.blocks_with_len[0].len = 0;
+  return ret;
+}
+
+// returns the new num_written.
+static inline uint32_t kwgc_states_defragger_experimental_params_free(KwgcStatesDefraggerExperimentalParams self[static 1]) {
+  uint32_t num_written = !self->block_len.len ? 0 : ((self->block_len.len - 1) << self->block_shift) + self->block_len.ptr[self->block_len.len - 1];
+  for (uint32_t i = (uint32_t)1 << MAX_BLOCK_SHIFT; i-- > 0; ) vecU32_free(&self->blocks_with_len[i]);
+  vecByte_free(&self->block_len);
+  return num_written;
+}
+
+// returns where a sibling list of num nodes should go.
+static inline uint32_t kwgc_states_defragger_reserve_cache_friendly(KwgcStatesDefraggerExperimentalParams params[static 1], uint32_t num) {
   // choose a cache-friendly page to place these.
+  uint8_t block_shift = params->block_shift;
+  uint32_t block_size = (uint32_t)1 << block_shift;
   uint32_t num_blocks = params->block_len.len;
   uint32_t initial_num_written = 0;
-  if (num > 16) {
+  if (num > block_size) {
     uint8_t tmp_u8 = 0;
-    // always even-align for 128 byte cache line machines.
-    if ((num_blocks & 1) == 1) {
+    // leave empty blocks until aligned.
+    while ((num_blocks & (params->align_blocks - 1)) != 0) {
       vecU32_push(&params->blocks_with_len[0], &num_blocks);
       vecByte_push(&params->block_len, &tmp_u8);
       ++num_blocks;
     }
-    initial_num_written = num_blocks << 4;
+    initial_num_written = num_blocks << block_shift;
     uint32_t inner_num = num;
-    tmp_u8 = 16;
-    while (inner_num > 16) {
+    tmp_u8 = (uint8_t)block_size;
+    while (inner_num > block_size) {
       vecByte_push(&params->block_len, &tmp_u8);
-      inner_num -= 16;
+      inner_num -= block_size;
     }
-    // this can be between 1 to 16.
-    if (inner_num < 16) {
+    // this can be between 1 to block_size.
+    if (inner_num < block_size) {
       uint32_t tmp_u32 = params->block_len.len;
       vecU32_push(&params->blocks_with_len[inner_num], &tmp_u32);
     }
-    tmp_u8 = inner_num;
+    tmp_u8 = (uint8_t)inner_num;
     vecByte_push(&params->block_len, &tmp_u8);
   } else {
-    // 1 <= num <= 16
-    for (uint8_t required_gap = 16 - (uint8_t)num; ; --required_gap) { // 0 <= required_gap <= 15
+    // 1 <= num <= block_size
+    for (uint8_t required_gap = (uint8_t)(block_size - num); ; --required_gap) { // 0 <= required_gap < block_size
       // if found, use it
       if (params->blocks_with_len[required_gap].len) {
         uint32_t place = params->blocks_with_len[required_gap].ptr[--params->blocks_with_len[required_gap].len];
         // use | instead of + because it cannot overflow
-        initial_num_written = (place << 4) | required_gap;
+        initial_num_written = (place << block_shift) | required_gap;
         // repurpose this variable.
-        required_gap += num; // 1 <= required_gap <= 16
-        if (required_gap < 16) vecU32_push(&params->blocks_with_len[required_gap], &place);
+        required_gap = (uint8_t)(required_gap + num); // 1 <= required_gap <= block_size
+        if (required_gap < block_size) vecU32_push(&params->blocks_with_len[required_gap], &place);
         params->block_len.ptr[place] = required_gap;
         break;
       }
       // if 0, add new row.
       if (!required_gap) {
-        initial_num_written = num_blocks << 4;
-        if (num < 16) vecU32_push(&params->blocks_with_len[num], &num_blocks);
-        uint8_t tmp_u8 = num;
+        initial_num_written = num_blocks << block_shift;
+        if (num < block_size) vecU32_push(&params->blocks_with_len[num], &num_blocks);
+        uint8_t tmp_u8 = (uint8_t)num;
         vecByte_push(&params->block_len, &tmp_u8);
         break;
       }
     }
   }
+  return initial_num_written;
+}
+
+// places the sibling list at p (a head) from initial_num_written, up to where an earlier list already placed the rest.
+static inline void kwgc_states_defragger_assign(KwgcStatesDefragger self[static 1], uint32_t p, uint32_t initial_num_written, uint32_t num) {
+  for (uint32_t ofs = 0; ofs < num; ++ofs) {
+    // prefer earlier index, so dawg part does not point to gaddag part.
+    uint32_t *dp = self->destination + p;
+    if (*dp) break;
+    *dp = initial_num_written + ofs;
+    p = self->states[p].next_index;
+  }
+}
+
+static inline void kwgc_states_defragger_defrag_cache_friendly(KwgcStatesDefragger self[static 1], KwgcStatesDefraggerExperimentalParams params[static 1], uint32_t p) {
+  p = self->head_indexes[p];
+  uint32_t *dp = self->destination + p;
+  if (*dp) return;
+  // temp value to break self-cycles.
+  *dp = (uint32_t)~0;
+  // non-legacy mode reserves the space first.
+  uint32_t num = self->to_end_lens[p];
+  uint32_t initial_num_written = kwgc_states_defragger_reserve_cache_friendly(params, num);
   uint32_t write_p = p;
   while (true) {
     uint32_t a = self->states[p].arc_index;
@@ -529,16 +940,18 @@ static inline void kwgc_states_defragger_defrag_cache_friendly(KwgcStatesDefragg
     if (!p) break;
   }
   *dp = 0;
-  for (uint32_t ofs = 0; ofs < num; ++ofs) {
-    // prefer earlier index, so dawg part does not point to gaddag part.
-    dp = self->destination + write_p;
-    if (*dp) break;
-    *dp = initial_num_written + ofs;
-    write_p = self->states[write_p].next_index;
-  }
+  kwgc_states_defragger_assign(self, write_p, initial_num_written, num);
   // non-legacy mode already reserves the space.
 }
 
+// same as kwgc_states_defragger_defrag_cache_friendly, but leaves the descendants for later.
+static inline void kwgc_states_defragger_place_cache_friendly(KwgcStatesDefragger self[static 1], KwgcStatesDefraggerExperimentalParams params[static 1], uint32_t p) {
+  p = self->head_indexes[p];
+  if (self->destination[p]) return;
+  uint32_t num = self->to_end_lens[p];
+  kwgc_states_defragger_assign(self, p, kwgc_states_defragger_reserve_cache_friendly(params, num), num);
+}
+
 uint32_t *qc_ref_num_ways; // temp global, do not free().
 uint32_t *qc_ref_to_end_lens; // temp global, do not free().
 int qc_build_experimental(const void *a, const void *b) {
@@ -559,38 +972,19 @@ int qc_build_experimental(const void *a, const void *b) {
 
 void kwgc_states_defragger_build_experimental(KwgcStatesDefragger self[static 1], uint32_t num_ways[static 1], uint32_t top_indexes[static 1]) {
   uint32_t states_len_minus_one = self->states_len - 1;
-  uint32_t *idxs = malloc_or_die(states_len_minus_one * sizeof(uint32_t));
+  uint32_t *idxs = malloc_tagged_or_die(AllocTag_DefragScratch, states_len_minus_one * sizeof(uint32_t));
   for (uint32_t p = 0; p < states_len_minus_one; ++p) idxs[p] = p + 1;
   qc_ref_num_ways = num_ways;
   qc_ref_to_end_lens = self->to_end_lens;
   qsort(idxs, states_len_minus_one, sizeof(uint32_t), qc_build_experimental);
 
-  KwgcStatesDefraggerExperimentalParams params = {
-      .block_len = vecByte_new(),
-      .blocks_with_len = {
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-      },
-    };
-  {
-    // num_written is either 1 or 2, both are < 16.
-    uint8_t num_written_as_byte = (uint8_t)self->num_written;
-    vecByte_push(&params.block_len, &num_written_as_byte);
-  }
-  {
-    uint32_t zero = 0;
-    vecU32_push(&params.blocks_with_len[self->num_written], &zero);
-  }
+  KwgcStatesDefraggerExperimentalParams params = kwgc_states_defragger_experimental_params_new(self->num_written);
   for (uint32_t i = 0; i < states_len_minus_one; ++i) {
     kwgc_states_defragger_defrag_cache_friendly(self, &params, top_indexes[idxs[i]]);
   }
-  self->num_written = ((params.block_len.len - 1) << 4) + params.block_len.ptr[params.block_len.len - 1];
+  self->num_written = kwgc_states_defragger_experimental_params_free(&params);
 
-  for (uint32_t i = 16; i-- > 0; ) vecU32_free(&params.blocks_with_len[i]);
-  vecByte_free(&params.block_len);
-  free(idxs);
+  free_tagged(AllocTag_DefragScratch, idxs, states_len_minus_one * sizeof(uint32_t));
 }
 
 bool *qc_ref_used_in_dawg; // temp global, do not free().
@@ -614,123 +1008,447 @@ int qc_build_wolges(const void *a, const void *b) {
   return 0;
 }
 
-void kwgc_states_defragger_build_wolges(KwgcStatesDefragger self[static 1], uint32_t num_ways[static 1], bool is_gaddag, uint32_t dawg_start_state) {
+int qc_build_hot(const void *a, const void *b) {
+  uint32_t pa = *(uint32_t *)a;
+  uint32_t pb = *(uint32_t *)b;
+  uint32_t num_ways_a = qc_ref_num_ways[pa];
+  uint32_t num_ways_b = qc_ref_num_ways[pb];
+  if (num_ways_b < num_ways_a) return -1;
+  if (num_ways_b > num_ways_a) return 1;
+  if (pa < pb) return -1;
+  if (pa > pb) return 1;
+  return 0;
+}
+
+uint64_t *qc_ref_heats; // temp global, do not free().
+int qc_build_profiled(const void *a, const void *b) {
+  uint32_t pa = *(uint32_t *)a;
+  uint32_t pb = *(uint32_t *)b;
+  uint64_t heat_a = qc_ref_heats[pa];
+  uint64_t heat_b = qc_ref_heats[pb];
+  if (heat_b < heat_a) return -1;
+  if (heat_b > heat_a) return 1;
+  if (pa < pb) return -1;
+  if (pa > pb) return 1;
+  return 0;
+}
+
+// returns all states except the sink, dawg first, then most reached, then longest.
+uint32_t *kwgc_states_defragger_wolges_order(KwgcStatesDefragger self[static 1], uint32_t num_ways[static 1], bool is_gaddag, uint32_t dawg_start_state) {
   uint32_t states_len_minus_one = self->states_len - 1;
-  uint32_t *idxs = malloc_or_die(states_len_minus_one * sizeof(uint32_t));
+  uint32_t *idxs = malloc_tagged_or_die(AllocTag_DefragScratch, states_len_minus_one * sizeof(uint32_t));
   for (uint32_t p = 0; p < states_len_minus_one; ++p) idxs[p] = p + 1;
   qc_ref_num_ways = num_ways;
   qc_ref_to_end_lens = self->to_end_lens;
   if (is_gaddag) {
     // Check which nodes are used in dawg.
-    bool *used_in_dawg = malloc_or_die(self->states_len * sizeof(bool));
+    bool *used_in_dawg = malloc_tagged_or_die(AllocTag_DefragScratch, self->states_len * sizeof(bool));
     used_in_dawg[0] = false;
     uint32_t p = 1;
     for (; p <= dawg_start_state; ++p) used_in_dawg[p] = true;
     for (; p < self->states_len; ++p) used_in_dawg[p] = used_in_dawg[self->states[p].next_index];
     qc_ref_used_in_dawg = used_in_dawg;
     qsort(idxs, states_len_minus_one, sizeof(uint32_t), qc_build_wolges);
-    free(used_in_dawg);
+    free_tagged(AllocTag_DefragScratch, used_in_dawg, self->states_len * sizeof(bool));
   } else {
     // All nodes are dawg nodes.
     qsort(idxs, states_len_minus_one, sizeof(uint32_t), qc_build_experimental);
   }
+  return idxs;
+}
 
-  KwgcStatesDefraggerExperimentalParams params = {
-      .block_len = vecByte_new(),
-      .blocks_with_len = {
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-        vecU32_new(), vecU32_new(), vecU32_new(), vecU32_new(),
-      },
-    };
-  {
-    // num_written is either 1 or 2, both are < 16.
-    uint8_t num_written_as_byte = (uint8_t)self->num_written;
-    vecByte_push(&params.block_len, &num_written_as_byte);
-  }
-  {
-    uint32_t zero = 0;
-    vecU32_push(&params.blocks_with_len[self->num_written], &zero);
+// heats is NULL, or per head state how often its sibling list was scanned (see kwgc_profile_heats).
+// hot lists are placed first, hottest first and without their descendants, so they share the fewest blocks.
+void kwgc_states_defragger_build_wolges(KwgcStatesDefragger self[static 1], uint32_t num_ways[static 1], uint64_t *heats, bool is_gaddag, uint32_t dawg_start_state) {
+  uint32_t states_len_minus_one = self->states_len - 1;
+  uint32_t *idxs = kwgc_states_defragger_wolges_order(self, num_ways, is_gaddag, dawg_start_state);
+
+  KwgcStatesDefraggerExperimentalParams params = kwgc_states_defragger_experimental_params_new(self->num_written);
+  if (heats) {
+    uint32_t num_hot = 0;
+    uint32_t *hot_idxs = malloc_tagged_or_die(AllocTag_DefragScratch, states_len_minus_one * sizeof(uint32_t));
+    for (uint32_t p = 1; p < self->states_len; ++p) if (heats[p]) hot_idxs[num_hot++] = p;
+    qc_ref_heats = heats;
+    qsort(hot_idxs, num_hot, sizeof(uint32_t), qc_build_profiled);
+    for (uint32_t i = 0; i < num_hot; ++i) {
+      kwgc_states_defragger_place_cache_friendly(self, &params, hot_idxs[i]);
+    }
+    free_tagged(AllocTag_DefragScratch, hot_idxs, states_len_minus_one * sizeof(uint32_t));
   }
   for (uint32_t i = 0; i < states_len_minus_one; ++i) {
     kwgc_states_defragger_defrag_cache_friendly(self, &params, idxs[i]);
   }
-  self->num_written = ((params.block_len.len - 1) << 4) + params.block_len.ptr[params.block_len.len - 1];
+  self->num_written = kwgc_states_defragger_experimental_params_free(&params);
 
-  for (uint32_t i = 16; i-- > 0; ) vecU32_free(&params.blocks_with_len[i]);
-  vecByte_free(&params.block_len);
-  free(idxs);
+  free_tagged(AllocTag_DefragScratch, idxs, states_len_minus_one * sizeof(uint32_t));
 }
 
-static inline void kwgc_write_node(uint8_t *pout, uint32_t defragged_arc_index, bool is_end, bool accepts, uint8_t tile) {
-  pout[0] = defragged_arc_index;
-  pout[1] = defragged_arc_index >> 8;
-  pout[2] = ((defragged_arc_index >> 16) & 0x3f) | (uint8_t)(is_end << 6) | (uint8_t)(accepts << 7);
-  pout[3] = tile;
+// 4K pages of 4-byte nodes.
+#define PAGED_LAYOUT_PAGE_SHIFT 10
+
+// whether reserving num more nodes keeps params within max_blocks blocks.
+static inline bool kwgc_states_defragger_fits_cache_friendly(KwgcStatesDefraggerExperimentalParams params[static 1], uint32_t num, uint32_t max_blocks) {
+  uint32_t block_size = (uint32_t)1 << params->block_shift;
+  uint32_t num_blocks = params->block_len.len;
+  if (num > block_size) {
+    uint32_t aligned_num_blocks = (num_blocks + params->align_blocks - 1) & ~(params->align_blocks - 1);
+    return aligned_num_blocks + ((num + block_size - 1) >> params->block_shift) <= max_blocks;
+  }
+  for (uint32_t used = block_size - num; ; --used) {
+    if (params->blocks_with_len[used].len) return true;
+    if (!used) return num_blocks < max_blocks;
+  }
 }
 
-// ret must initially be empty.
-void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_gaddag, BuildLayout build_layout) {
-  KwgcStateMaker state_maker = kwgc_state_maker_new();
-  // The sink state always exists.
-  vecKwgcState_push(&state_maker.states, &(KwgcState){
-      .arc_index = 0,
-      .next_index = 0,
-      .tile = 0,
-      .accepts = false,
-    });
-  uint32_t gaddag_start_state = 0;
-  khmKwgcStateU32_set(&state_maker.states_finder, state_maker.states.ptr, &gaddag_start_state);
-  uint32_t dawg_start_state = kwgc_state_maker_make_dawg(&state_maker, sorted_machine_words, 0, false);
-  if (is_gaddag) {
-    OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
-    Wordlist gaddag_wl = wordlist_new();
-    for (size_t machine_word_index = 0; machine_word_index < sorted_machine_words->tiles_slices.len; ++machine_word_index) {
-      OfsLen *this_word = &sorted_machine_words->tiles_slices.ptr[machine_word_index];
-      uint32_t prefix_len = 0;
-      if (machine_word_index > 0) {
-        OfsLen *prev_word = &sorted_machine_words->tiles_slices.ptr[machine_word_index - 1];
-        uint32_t max_prefix_len = prev_word->len - 1; // - 1 because CAR -> CARE means we still need to emit RAC@.
-        if (this_word->len < max_prefix_len) max_prefix_len = this_word->len;
-        while (prefix_len < max_prefix_len &&
-            sorted_machine_words->tiles_bytes.ptr[prev_word->ofs + prefix_len] ==
-            sorted_machine_words->tiles_bytes.ptr[this_word->ofs + prefix_len])
-          ++prefix_len;
+// two levels: sibling lists are clustered into pages breadth first from a seed,
+// so the top of a subtree shares a page, and within a page they are packed into blocks as usual.
+// seeds are the dawg root, lists that did not fit an earlier page, the gaddag root, then the rest
+// in wolges order (through top_indexes, so a list with a single parent is reached from the top of that chain).
+// a seed is always placed, on a fresh page if needed, so every seed makes progress.
+void kwgc_states_defragger_build_paged(KwgcStatesDefragger self[static 1], uint32_t num_ways[static 1], uint32_t top_indexes[static 1], bool is_gaddag, uint32_t dawg_start_state, uint32_t gaddag_start_state) {
+  uint32_t states_len_minus_one = self->states_len - 1;
+  uint32_t *idxs = kwgc_states_defragger_wolges_order(self, num_ways, is_gaddag, dawg_start_state);
+  uint32_t blocks_per_page = (uint32_t)1 << (PAGED_LAYOUT_PAGE_SHIFT - layout_block_shift);
+  uint32_t page_base = 0;
+  KwgcStatesDefraggerExperimentalParams params = kwgc_states_defragger_experimental_params_new(self->num_written);
+  VecU32 queue = vecU32_new_tagged(AllocTag_DefragScratch);
+  VecU32 seeds = vecU32_new_tagged(AllocTag_DefragScratch);
+  size_t queue_head = 0, seeds_head = 0;
+  uint32_t next_idx = 0;
+  bool is_seed = false;
+  // lookups start from the roots. the whole dawg goes first, so it stays compact.
+  vecU32_push(&seeds, &dawg_start_state);
+  while (true) {
+    if (queue_head == queue.len) {
+      queue.len = queue_head = 0;
+      uint32_t seed = 0;
+      while (!seed && seeds_head < seeds.len) {
+        seed = self->head_indexes[seeds.ptr[seeds_head++]];
+        if (self->destination[seed]) seed = 0;
       }
-      // CARE = ERAC, RAC@, AC@, C@
-      for (size_t i = this_word->len; i > 0; --i) {
-        vecByte_push(&gaddag_wl.tiles_bytes, &sorted_machine_words->tiles_bytes.ptr[this_word->ofs + i - 1]);
+      if (!seed && is_gaddag && !self->destination[self->head_indexes[gaddag_start_state]]) seed = self->head_indexes[gaddag_start_state];
+      while (!seed && next_idx < states_len_minus_one) {
+        seed = self->head_indexes[top_indexes[idxs[next_idx++]]];
+        if (self->destination[seed]) seed = 0;
       }
-      cur_ofs_len.len = this_word->len;
-      vecOfsLen_push(&gaddag_wl.tiles_slices, &cur_ofs_len);
-      cur_ofs_len.ofs += cur_ofs_len.len;
-      uint8_t zero = 0;
-      for (size_t j = this_word->len - 1; j > prefix_len; --j) {
-        for (size_t i = j; i > 0; --i) {
-          vecByte_push(&gaddag_wl.tiles_bytes, &sorted_machine_words->tiles_bytes.ptr[this_word->ofs + i - 1]);
-        }
-        vecByte_push(&gaddag_wl.tiles_bytes, &zero);
-        cur_ofs_len.len = j + 1;
-        vecOfsLen_push(&gaddag_wl.tiles_slices, &cur_ofs_len);
-        cur_ofs_len.ofs += cur_ofs_len.len;
+      if (!seed) break;
+      if (!kwgc_states_defragger_fits_cache_friendly(&params, self->to_end_lens[seed], blocks_per_page)) {
+        // start a new page, the rest of this one stays empty.
+        // a page can only have grown past its end if --align is close to the page size.
+        uint32_t page_len = kwgc_states_defragger_experimental_params_free(&params);
+        page_base += (page_len + ((uint32_t)1 << PAGED_LAYOUT_PAGE_SHIFT) - 1) & ~(((uint32_t)1 << PAGED_LAYOUT_PAGE_SHIFT) - 1);
+        params = kwgc_states_defragger_experimental_params_new_page();
       }
+      vecU32_push(&queue, &seed);
+      is_seed = true;
+    }
+    uint32_t p = self->head_indexes[queue.ptr[queue_head++]];
+    bool must_place = is_seed;
+    is_seed = false;
+    if (self->destination[p]) continue;
+    uint32_t num = self->to_end_lens[p];
+    // a seed that did not fit the last page is placed even if it does not fit a fresh one either.
+    if (!must_place && !kwgc_states_defragger_fits_cache_friendly(&params, num, blocks_per_page)) {
+      vecU32_push(&seeds, &p);
+      continue;
+    }
+    kwgc_states_defragger_assign(self, p, page_base + kwgc_states_defragger_reserve_cache_friendly(&params, num), num);
+    for (uint32_t q = p; q; q = self->states[q].next_index) {
+      uint32_t a = self->states[q].arc_index;
+      if (a && !self->destination[self->head_indexes[a]]) vecU32_push(&queue, &a);
     }
-    wordlist_sort(&gaddag_wl);
-    gaddag_start_state = kwgc_state_maker_make_dawg(&state_maker, &gaddag_wl, dawg_start_state, true);
-    wordlist_free(&gaddag_wl);
   }
-  uint32_t *head_indexes = NULL;
-  switch (build_layout) {
-    case BuildLayout_Magpie:
-      break;
-    case BuildLayout_Legacy:
-    case BuildLayout_MagpieMerged:
-    case BuildLayout_Experimental:
-    case BuildLayout_Wolges:
-      head_indexes = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
-      for (uint32_t p = 0; p < state_maker.states.len; ++p) head_indexes[p] = p;
-      // point to immediate prev.
+  self->num_written = page_base + kwgc_states_defragger_experimental_params_free(&params);
+  vecU32_free(&seeds);
+  vecU32_free(&queue);
+  free_tagged(AllocTag_DefragScratch, idxs, states_len_minus_one * sizeof(uint32_t));
+}
+
+// adds weight to every sibling list scanned while looking up tiles from the list at p.
+static inline void kwgc_profile_walk(KwgcState *states, uint32_t *head_indexes, uint64_t *heats, uint32_t p, const uint8_t *tiles, size_t len, uint64_t weight) {
+  for (size_t i = 0; i < len && p; ++i) {
+    heats[head_indexes[p]] += weight;
+    while (p && states[p].tile != tiles[i]) p = states[p].next_index;
+    if (p) p = states[p].arc_index;
+  }
+}
+
+// per head state, the weighted number of times the profile scans its sibling list.
+// every gaddag anchor of a word counts, like a move generator would look it up.
+uint64_t *kwgc_profile_heats(KwgcState *states, uint32_t states_len, uint32_t *head_indexes, const LayoutProfile *profile, uint32_t dawg_start_state, uint32_t gaddag_start_state, bool is_gaddag) {
+  uint64_t *heats = malloc_tagged_or_die(AllocTag_Profile, states_len * sizeof(uint64_t));
+  memset(heats, 0, states_len * sizeof(uint64_t));
+  if (!profile) return heats;
+  size_t max_len = 0;
+  for (size_t i = 0; i < profile->words.tiles_slices.len; ++i) {
+    if (profile->words.tiles_slices.ptr[i].len > max_len) max_len = profile->words.tiles_slices.ptr[i].len;
+  }
+  uint8_t *path = malloc_tagged_or_die(AllocTag_Profile, max_len + 1);
+  for (size_t i = 0; i < profile->words.tiles_slices.len; ++i) {
+    OfsLen *this_word = &profile->words.tiles_slices.ptr[i];
+    uint8_t *tiles = profile->words.tiles_bytes.ptr + this_word->ofs;
+    uint64_t weight = profile->weights.ptr[i];
+    kwgc_profile_walk(states, head_indexes, heats, dawg_start_state, tiles, this_word->len, weight);
+    if (!is_gaddag) continue;
+    // CARE = ERAC, RAC@E, AC@RE, C@ARE
+    for (size_t anchor = 0; anchor < this_word->len; ++anchor) {
+      size_t path_len = 0;
+      for (size_t j = anchor + 1; j-- > 0; ) path[path_len++] = tiles[j];
+      if (anchor + 1 < this_word->len) {
+        path[path_len++] = 0;
+        for (size_t j = anchor + 1; j < this_word->len; ++j) path[path_len++] = tiles[j];
+      }
+      kwgc_profile_walk(states, head_indexes, heats, gaddag_start_state, path, path_len, weight);
+    }
+  }
+  free_tagged(AllocTag_Profile, path, max_len + 1);
+  return heats;
+}
+
+// heats for the hot layout: lists within layout_hot_depth of a root, shallowest first,
+// then the layout_hot_top most reached lists. all others are cold (0).
+uint64_t *kwgc_hot_region_heats(KwgcState *states, uint32_t states_len, uint32_t *head_indexes, uint32_t *num_ways, uint32_t dawg_start_state, uint32_t gaddag_start_state, bool is_gaddag) {
+  uint64_t *heats = malloc_tagged_or_die(AllocTag_Profile, states_len * sizeof(uint64_t));
+  memset(heats, 0, states_len * sizeof(uint64_t));
+  uint32_t *queue = malloc_tagged_or_die(AllocTag_Profile, states_len * sizeof(uint32_t));
+  uint32_t queue_len = 0;
+  // breadth first from both roots, each level gets a lower heat than the one before.
+  if (layout_hot_depth > 0) {
+    if (dawg_start_state) queue[queue_len++] = head_indexes[dawg_start_state];
+    if (is_gaddag && gaddag_start_state && (!queue_len || queue[0] != head_indexes[gaddag_start_state])) queue[queue_len++] = head_indexes[gaddag_start_state];
+    for (uint32_t i = 0; i < queue_len; ++i) heats[queue[i]] = (uint64_t)layout_hot_depth << 32 | num_ways[queue[i]];
+  }
+  for (uint32_t queue_head = 0, level_end = queue_len, depth = 1; queue_head < queue_len && depth < layout_hot_depth; ++depth) {
+    uint64_t level_heat = (uint64_t)(layout_hot_depth - depth) << 32;
+    for (; queue_head < level_end; ++queue_head) {
+      for (uint32_t p = queue[queue_head]; p; p = states[p].next_index) {
+        uint32_t a = states[p].arc_index;
+        if (!a || heats[head_indexes[a]]) continue;
+        queue[queue_len++] = head_indexes[a];
+        heats[head_indexes[a]] = level_heat | num_ways[head_indexes[a]];
+      }
+    }
+    level_end = queue_len;
+  }
+  if (layout_hot_top > 0) {
+    uint32_t num_heads = 0;
+    for (uint32_t p = 1; p < states_len; ++p) if (head_indexes[p] == p) queue[num_heads++] = p;
+    qc_ref_num_ways = num_ways;
+    qsort(queue, num_heads, sizeof(uint32_t), qc_build_hot);
+    for (uint32_t i = 0; i < num_heads && i < layout_hot_top; ++i) {
+      // num_ways is at least 1 for reachable states.
+      if (!heats[queue[i]]) heats[queue[i]] = num_ways[queue[i]];
+    }
+  }
+  free_tagged(AllocTag_Profile, queue, states_len * sizeof(uint32_t));
+  return heats;
+}
+
+// sidecars wanted, set by --jump=K, --child-masks, --hooks, --lengths and --counts. see write_sidecar_u32.
+uint32_t sidecar_jump_depth = 0; // 0 for none.
+#define SIDECAR_MAX_JUMP_DEPTH 4
+#define SIDECAR_MAX_JUMP_ENTRIES ((size_t)1 << 26) // 256MB.
+#define KLV_DENSE_MAX_RACKS ((uint64_t)1 << 28) // 1GB, for -klv-dense.
+bool sidecar_child_masks = false;
+bool sidecar_hooks = false;
+bool sidecar_lengths = false;
+bool sidecar_counts = false;
+
+// per-node sidecars, indexed like the output. each is empty unless wanted. roots and gaps are 0.
+typedef struct {
+  VecU64 child_masks; // bit c of [i] is set if tile c is in the sibling list from node i to its end.
+  VecU64 hooks; // same for [2 * i + 1], and [2 * i] only has the tiles that accept.
+  VecU32 lengths; // bit k of [i] is set if a word ends k tiles below node i, bit 31 for 31 or more.
+  VecU32 counts; // words in the sibling list from node i to its end, like kwg_count_words.
+} KwgcSidecars;
+
+static inline KwgcSidecars kwgc_sidecars_new(void) {
+  return (KwgcSidecars){
+    .child_masks = vecU64_new_tagged(AllocTag_Sidecar),
+    .hooks = vecU64_new_tagged(AllocTag_Sidecar),
+    .lengths = vecU32_new_tagged(AllocTag_Sidecar),
+    .counts = vecU32_new_tagged(AllocTag_Sidecar),
+  };
+}
+
+static inline void kwgc_sidecars_free(KwgcSidecars self[static 1]) {
+  vecU32_free(&self->counts);
+  vecU32_free(&self->lengths);
+  vecU64_free(&self->hooks);
+  vecU64_free(&self->child_masks);
+}
+
+// copies width values per state to every node written for that state, the same way kwgc_build emits nodes.
+static inline void kwgc_sidecar_scatter_u64(VecU64 out[static 1], const uint64_t *values, uint32_t width, KwgcState *states, uint32_t states_len, uint32_t *destination, uint32_t num_nodes) {
+  vecU64_ensure_cap_exact(out, out->len = (size_t)num_nodes * width);
+  memset(out->ptr, 0, out->len * sizeof(uint64_t));
+  for (uint32_t outer_p = 1; outer_p < states_len; ++outer_p) {
+    uint32_t dp = destination[outer_p];
+    if (dp) {
+      for (uint32_t p = outer_p; ; ++dp) {
+        memcpy(out->ptr + (size_t)dp * width, values + (size_t)p * width, width * sizeof(uint64_t));
+        p = states[p].next_index;
+        if (!p) break;
+      }
+    }
+  }
+}
+
+// same code, just changed u64 to u32 and without width.
+static inline void kwgc_sidecar_scatter_u32(VecU32 out[static 1], const uint32_t *values, KwgcState *states, uint32_t states_len, uint32_t *destination, uint32_t num_nodes) {
+  vecU32_ensure_cap_exact(out, out->len = num_nodes);
+  memset(out->ptr, 0, out->len * sizeof(uint32_t));
+  for (uint32_t outer_p = 1; outer_p < states_len; ++outer_p) {
+    uint32_t dp = destination[outer_p];
+    if (dp) {
+      for (uint32_t p = outer_p; ; ++dp) {
+        out->ptr[dp] = values[p];
+        p = states[p].next_index;
+        if (!p) break;
+      }
+    }
+  }
+}
+
+// each pass goes up the states, whose arc_index and next_index are always smaller.
+// returns false (after reporting) if the wanted sidecars cannot represent the states.
+bool kwgc_sidecars_fill(KwgcSidecars self[static 1], KwgcState *states, uint32_t states_len, uint32_t *destination, uint32_t num_nodes) {
+  if (sidecar_child_masks || sidecar_hooks) {
+    // hooks[2 * p] accepting tiles, hooks[2 * p + 1] all tiles.
+    uint64_t *hooks = malloc_tagged_or_die(AllocTag_Sidecar, states_len * 2 * sizeof(uint64_t));
+    hooks[0] = hooks[1] = 0;
+    for (uint32_t p = 1; p < states_len; ++p) {
+      KwgcState *state = states + p;
+      if (state->tile >= 64) {
+        fprintf(stderr, "tile %u does not fit in a mask\n", state->tile);
+        free_tagged(AllocTag_Sidecar, hooks, states_len * 2 * sizeof(uint64_t));
+        return false;
+      }
+      uint64_t bit = (uint64_t)1 << state->tile;
+      hooks[2 * p] = (state->accepts ? bit : 0) | hooks[2 * state->next_index];
+      hooks[2 * p + 1] = bit | hooks[2 * state->next_index + 1];
+    }
+    if (sidecar_hooks) kwgc_sidecar_scatter_u64(&self->hooks, hooks, 2, states, states_len, destination, num_nodes);
+    if (sidecar_child_masks) {
+      // reuses the first half for the all tiles masks.
+      for (uint32_t p = 0; p < states_len; ++p) hooks[p] = hooks[2 * p + 1];
+      kwgc_sidecar_scatter_u64(&self->child_masks, hooks, 1, states, states_len, destination, num_nodes);
+    }
+    free_tagged(AllocTag_Sidecar, hooks, states_len * 2 * sizeof(uint64_t));
+  }
+  if (sidecar_lengths) {
+    // lengths[p] is for the state, list_lengths[p] for its sibling list from p to the end.
+    uint32_t *lengths = malloc_tagged_or_die(AllocTag_Sidecar, states_len * sizeof(uint32_t));
+    uint32_t *list_lengths = malloc_tagged_or_die(AllocTag_Sidecar, states_len * sizeof(uint32_t));
+    lengths[0] = list_lengths[0] = 0;
+    for (uint32_t p = 1; p < states_len; ++p) {
+      KwgcState *state = states + p;
+      uint32_t below = list_lengths[state->arc_index];
+      // one tile further down, lengths that were 30 or more become 31 or more.
+      lengths[p] = (uint32_t)state->accepts | below << 1 | (uint32_t)!!(below >> 30) << 31;
+      list_lengths[p] = lengths[p] | list_lengths[state->next_index];
+    }
+    kwgc_sidecar_scatter_u32(&self->lengths, lengths, states, states_len, destination, num_nodes);
+    free_tagged(AllocTag_Sidecar, list_lengths, states_len * sizeof(uint32_t));
+    free_tagged(AllocTag_Sidecar, lengths, states_len * sizeof(uint32_t));
+  }
+  if (sidecar_counts) {
+    // like num_ways, but from the other end.
+    uint32_t *counts = malloc_tagged_or_die(AllocTag_Sidecar, states_len * sizeof(uint32_t));
+    counts[0] = 0;
+    for (uint32_t p = 1; p < states_len; ++p) {
+      KwgcState *state = states + p;
+      uint64_t count = (uint64_t)state->accepts + counts[state->arc_index] + counts[state->next_index];
+      if (count > (uint32_t)~0) {
+        fputs("too many words to count in a uint32_t\n", stderr);
+        free_tagged(AllocTag_Sidecar, counts, states_len * sizeof(uint32_t));
+        return false;
+      }
+      counts[p] = (uint32_t)count;
+    }
+    kwgc_sidecar_scatter_u32(&self->counts, counts, states, states_len, destination, num_nodes);
+    free_tagged(AllocTag_Sidecar, counts, states_len * sizeof(uint32_t));
+  }
+  return true;
+}
+
+static inline void kwgc_write_node(uint8_t *pout, uint32_t defragged_arc_index, bool is_end, bool accepts, uint8_t tile) {
+  pout[0] = defragged_arc_index;
+  pout[1] = defragged_arc_index >> 8;
+  pout[2] = ((defragged_arc_index >> 16) & 0x3f) | (uint8_t)(is_end << 6) | (uint8_t)(accepts << 7);
+  pout[3] = tile;
+}
+
+// ret must initially be empty.
+// profile is only used by the profiled layout, and may be NULL.
+// sidecars may be NULL, otherwise the wanted ones are filled in. ret is left empty if that fails.
+void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_gaddag, BuildLayout build_layout, const LayoutProfile *profile, KwgcSidecars *sidecars) {
+  KwgcStateMaker state_maker = kwgc_state_maker_new();
+  // The sink state always exists.
+  vecKwgcState_push(&state_maker.states, &(KwgcState){
+      .arc_index = 0,
+      .next_index = 0,
+      .tile = 0,
+      .accepts = false,
+    });
+  uint32_t gaddag_start_state = 0;
+  khmKwgcStateU32_set(&state_maker.states_finder, state_maker.states.ptr, &gaddag_start_state);
+  uint32_t dawg_start_state = kwgc_state_maker_make_dawg(&state_maker, sorted_machine_words, 0, false);
+  stats_end_phase(Phase_DawgMinimize);
+  if (is_gaddag) {
+    OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
+    Wordlist gaddag_wl = wordlist_new(AllocTag_GaddagWords);
+    for (size_t machine_word_index = 0; machine_word_index < sorted_machine_words->tiles_slices.len; ++machine_word_index) {
+      OfsLen *this_word = &sorted_machine_words->tiles_slices.ptr[machine_word_index];
+      uint32_t prefix_len = 0;
+      if (machine_word_index > 0) {
+        OfsLen *prev_word = &sorted_machine_words->tiles_slices.ptr[machine_word_index - 1];
+        uint32_t max_prefix_len = prev_word->len - 1; // - 1 because CAR -> CARE means we still need to emit RAC@.
+        if (this_word->len < max_prefix_len) max_prefix_len = this_word->len;
+        while (prefix_len < max_prefix_len &&
+            sorted_machine_words->tiles_bytes.ptr[prev_word->ofs + prefix_len] ==
+            sorted_machine_words->tiles_bytes.ptr[this_word->ofs + prefix_len])
+          ++prefix_len;
+      }
+      // CARE = ERAC, RAC@, AC@, C@
+      for (size_t i = this_word->len; i > 0; --i) {
+        vecByte_push(&gaddag_wl.tiles_bytes, &sorted_machine_words->tiles_bytes.ptr[this_word->ofs + i - 1]);
+      }
+      cur_ofs_len.len = this_word->len;
+      vecOfsLen_push(&gaddag_wl.tiles_slices, &cur_ofs_len);
+      cur_ofs_len.ofs += cur_ofs_len.len;
+      uint8_t zero = 0;
+      for (size_t j = this_word->len - 1; j > prefix_len; --j) {
+        for (size_t i = j; i > 0; --i) {
+          vecByte_push(&gaddag_wl.tiles_bytes, &sorted_machine_words->tiles_bytes.ptr[this_word->ofs + i - 1]);
+        }
+        vecByte_push(&gaddag_wl.tiles_bytes, &zero);
+        cur_ofs_len.len = j + 1;
+        vecOfsLen_push(&gaddag_wl.tiles_slices, &cur_ofs_len);
+        cur_ofs_len.ofs += cur_ofs_len.len;
+      }
+    }
+    stats_end_phase(Phase_GaddagExpand);
+    wordlist_sort(&gaddag_wl);
+    stats_end_phase(Phase_GaddagSort);
+    gaddag_start_state = kwgc_state_maker_make_dawg(&state_maker, &gaddag_wl, dawg_start_state, true);
+    stats_end_phase(Phase_GaddagMinimize);
+    wordlist_free(&gaddag_wl);
+  }
+  uint32_t *head_indexes = NULL;
+  switch (build_layout) {
+    case BuildLayout_Magpie:
+      break;
+    case BuildLayout_Legacy:
+    case BuildLayout_MagpieMerged:
+    case BuildLayout_Experimental:
+    case BuildLayout_Wolges:
+    case BuildLayout_Profiled:
+    case BuildLayout_Paged:
+    case BuildLayout_Hot:
+      head_indexes = malloc_tagged_or_die(AllocTag_HeadIndexes, state_maker.states.len * sizeof(uint32_t));
+      for (uint32_t p = 0; p < state_maker.states.len; ++p) head_indexes[p] = p;
+      // point to immediate prev.
       for (uint32_t p = state_maker.states.len - 1; p > 0; --p) {
         head_indexes[state_maker.states.ptr[p].next_index] = p;
       }
@@ -740,19 +1458,22 @@ void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_ga
         head_indexes[p] = head_indexes[head_indexes[p]];
       }
   }
-  uint32_t *to_end_lens = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+  uint32_t *to_end_lens = malloc_tagged_or_die(AllocTag_ToEndLens, state_maker.states.len * sizeof(uint32_t));
   for (uint32_t p = 0; p < state_maker.states.len; ++p) {
     to_end_lens[p] = 1;
     uint32_t next = state_maker.states.ptr[p].next_index;
     if (next) to_end_lens[p] += to_end_lens[next];
   }
-  uint32_t *destination = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+  uint32_t *destination = malloc_tagged_or_die(AllocTag_Destination, state_maker.states.len * sizeof(uint32_t));
   memset(destination, 0, state_maker.states.len * sizeof(uint32_t));
   uint32_t *num_ways = NULL;
   switch (build_layout) {
     case BuildLayout_Experimental:
     case BuildLayout_Wolges:
-      num_ways = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+    case BuildLayout_Profiled:
+    case BuildLayout_Paged:
+    case BuildLayout_Hot:
+      num_ways = malloc_tagged_or_die(AllocTag_NumWays, state_maker.states.len * sizeof(uint32_t));
       memset(num_ways, 0, state_maker.states.len * sizeof(uint32_t));
       num_ways[dawg_start_state] = 1;
       if (is_gaddag) num_ways[gaddag_start_state] = 1;
@@ -773,7 +1494,8 @@ void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_ga
   uint32_t *top_indexes = NULL;
   switch (build_layout) {
     case BuildLayout_Experimental:
-      top_indexes = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+    case BuildLayout_Paged:
+      top_indexes = malloc_tagged_or_die(AllocTag_TopIndexes, state_maker.states.len * sizeof(uint32_t));
       memset(top_indexes, 0, state_maker.states.len * sizeof(uint32_t));
       for (uint32_t p = 1; p < state_maker.states.len; ++p) {
         uint32_t *pp_dest = top_indexes + state_maker.states.ptr[p].arc_index;
@@ -794,8 +1516,11 @@ void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_ga
     case BuildLayout_Magpie:
     case BuildLayout_MagpieMerged:
     case BuildLayout_Wolges:
+    case BuildLayout_Profiled:
+    case BuildLayout_Hot:
       break;
   }
+  stats_end_phase(Phase_LayoutPasses);
   KwgcStatesDefragger states_defragger = {
       .states = (KwgcState *)state_maker.states.ptr,
       .states_len = state_maker.states.len,
@@ -822,16 +1547,35 @@ void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_ga
       kwgc_states_defragger_build_experimental(&states_defragger, num_ways, top_indexes);
       break;
     case BuildLayout_Wolges:
-      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, is_gaddag, dawg_start_state);
+      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, NULL, is_gaddag, dawg_start_state);
+      break;
+    case BuildLayout_Profiled: {
+      uint64_t *heats = kwgc_profile_heats(states_defragger.states, states_defragger.states_len, head_indexes, profile, dawg_start_state, gaddag_start_state, is_gaddag);
+      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, heats, is_gaddag, dawg_start_state);
+      free_tagged(AllocTag_Profile, heats, states_defragger.states_len * sizeof(uint64_t));
+      break;
+    }
+    case BuildLayout_Hot: {
+      uint64_t *heats = kwgc_hot_region_heats(states_defragger.states, states_defragger.states_len, head_indexes, num_ways, dawg_start_state, gaddag_start_state, is_gaddag);
+      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, heats, is_gaddag, dawg_start_state);
+      free_tagged(AllocTag_Profile, heats, states_defragger.states_len * sizeof(uint64_t));
+      break;
+    }
+    case BuildLayout_Paged:
+      kwgc_states_defragger_build_paged(&states_defragger, num_ways, top_indexes, is_gaddag, dawg_start_state, gaddag_start_state);
       break;
   }
   destination[0] = 0; // useful for empty lexicon.
+  stats_end_phase(Phase_Defrag);
+  stats.states += state_maker.states.len;
   if (states_defragger.num_written > 0x400000) {
     // the format can only have 0x400000 elements, each has 4 bytes
     fprintf(stderr, "this format cannot have %u nodes\n", states_defragger.num_written);
-    free(destination);
-    free(to_end_lens);
-    free(head_indexes);
+    free_tagged(AllocTag_TopIndexes, top_indexes, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_NumWays, num_ways, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_Destination, destination, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_ToEndLens, to_end_lens, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_HeadIndexes, head_indexes, state_maker.states.len * sizeof(uint32_t));
     kwgc_state_maker_free(&state_maker);
     return;
   }
@@ -850,11 +1594,19 @@ void kwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_ga
       }
     }
   }
-  free(top_indexes);
-  free(num_ways);
-  free(destination);
-  free(to_end_lens);
-  free(head_indexes);
+  stats.nodes_written += ret->len;
+  // real nodes are never all zero.
+  for (uint32_t i = 0; i < ret->len; ++i) stats.gap_nodes += !ret->ptr[i];
+  if (sidecars && !kwgc_sidecars_fill(sidecars, states_defragger.states, states_defragger.states_len, destination, (uint32_t)ret->len)) ret->len = 0;
+  stats_end_phase(Phase_Emit);
+#ifdef KHM_INSTRUMENT
+  khmKwgcStateU32_fprint_instrument(stderr, &state_maker.states_finder);
+#endif
+  free_tagged(AllocTag_TopIndexes, top_indexes, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_NumWays, num_ways, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_Destination, destination, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_ToEndLens, to_end_lens, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_HeadIndexes, head_indexes, state_maker.states.len * sizeof(uint32_t));
   kwgc_state_maker_free(&state_maker);
 }
 
@@ -867,7 +1619,7 @@ static inline void kbwgc_write_node(uint8_t *pout, uint32_t defragged_arc_index,
 
 // almost same as kwgc_build. (calls kbwgc_write_node and allows more nodes.)
 // ret must initially be empty.
-void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_gaddag, BuildLayout build_layout) {
+void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_gaddag, BuildLayout build_layout, const LayoutProfile *profile, KwgcSidecars *sidecars) {
   KwgcStateMaker state_maker = kwgc_state_maker_new();
   // The sink state always exists.
   vecKwgcState_push(&state_maker.states, &(KwgcState){
@@ -879,9 +1631,10 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
   uint32_t gaddag_start_state = 0;
   khmKwgcStateU32_set(&state_maker.states_finder, state_maker.states.ptr, &gaddag_start_state);
   uint32_t dawg_start_state = kwgc_state_maker_make_dawg(&state_maker, sorted_machine_words, 0, false);
+  stats_end_phase(Phase_DawgMinimize);
   if (is_gaddag) {
     OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
-    Wordlist gaddag_wl = wordlist_new();
+    Wordlist gaddag_wl = wordlist_new(AllocTag_GaddagWords);
     for (size_t machine_word_index = 0; machine_word_index < sorted_machine_words->tiles_slices.len; ++machine_word_index) {
       OfsLen *this_word = &sorted_machine_words->tiles_slices.ptr[machine_word_index];
       uint32_t prefix_len = 0;
@@ -912,8 +1665,11 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
         cur_ofs_len.ofs += cur_ofs_len.len;
       }
     }
+    stats_end_phase(Phase_GaddagExpand);
     wordlist_sort(&gaddag_wl);
+    stats_end_phase(Phase_GaddagSort);
     gaddag_start_state = kwgc_state_maker_make_dawg(&state_maker, &gaddag_wl, dawg_start_state, true);
+    stats_end_phase(Phase_GaddagMinimize);
     wordlist_free(&gaddag_wl);
   }
   uint32_t *head_indexes = NULL;
@@ -924,7 +1680,10 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
     case BuildLayout_MagpieMerged:
     case BuildLayout_Experimental:
     case BuildLayout_Wolges:
-      head_indexes = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+    case BuildLayout_Profiled:
+    case BuildLayout_Paged:
+    case BuildLayout_Hot:
+      head_indexes = malloc_tagged_or_die(AllocTag_HeadIndexes, state_maker.states.len * sizeof(uint32_t));
       for (uint32_t p = 0; p < state_maker.states.len; ++p) head_indexes[p] = p;
       // point to immediate prev.
       for (uint32_t p = state_maker.states.len - 1; p > 0; --p) {
@@ -936,19 +1695,22 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
         head_indexes[p] = head_indexes[head_indexes[p]];
       }
   }
-  uint32_t *to_end_lens = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+  uint32_t *to_end_lens = malloc_tagged_or_die(AllocTag_ToEndLens, state_maker.states.len * sizeof(uint32_t));
   for (uint32_t p = 0; p < state_maker.states.len; ++p) {
     to_end_lens[p] = 1;
     uint32_t next = state_maker.states.ptr[p].next_index;
     if (next) to_end_lens[p] += to_end_lens[next];
   }
-  uint32_t *destination = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+  uint32_t *destination = malloc_tagged_or_die(AllocTag_Destination, state_maker.states.len * sizeof(uint32_t));
   memset(destination, 0, state_maker.states.len * sizeof(uint32_t));
   uint32_t *num_ways = NULL;
   switch (build_layout) {
     case BuildLayout_Experimental:
     case BuildLayout_Wolges:
-      num_ways = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+    case BuildLayout_Profiled:
+    case BuildLayout_Paged:
+    case BuildLayout_Hot:
+      num_ways = malloc_tagged_or_die(AllocTag_NumWays, state_maker.states.len * sizeof(uint32_t));
       memset(num_ways, 0, state_maker.states.len * sizeof(uint32_t));
       num_ways[dawg_start_state] = 1;
       if (is_gaddag) num_ways[gaddag_start_state] = 1;
@@ -969,7 +1731,8 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
   uint32_t *top_indexes = NULL;
   switch (build_layout) {
     case BuildLayout_Experimental:
-      top_indexes = malloc_or_die(state_maker.states.len * sizeof(uint32_t));
+    case BuildLayout_Paged:
+      top_indexes = malloc_tagged_or_die(AllocTag_TopIndexes, state_maker.states.len * sizeof(uint32_t));
       memset(top_indexes, 0, state_maker.states.len * sizeof(uint32_t));
       for (uint32_t p = 1; p < state_maker.states.len; ++p) {
         uint32_t *pp_dest = top_indexes + state_maker.states.ptr[p].arc_index;
@@ -990,8 +1753,11 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
     case BuildLayout_Magpie:
     case BuildLayout_MagpieMerged:
     case BuildLayout_Wolges:
+    case BuildLayout_Profiled:
+    case BuildLayout_Hot:
       break;
   }
+  stats_end_phase(Phase_LayoutPasses);
   KwgcStatesDefragger states_defragger = {
       .states = (KwgcState *)state_maker.states.ptr,
       .states_len = state_maker.states.len,
@@ -1018,16 +1784,35 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
       kwgc_states_defragger_build_experimental(&states_defragger, num_ways, top_indexes);
       break;
     case BuildLayout_Wolges:
-      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, is_gaddag, dawg_start_state);
+      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, NULL, is_gaddag, dawg_start_state);
+      break;
+    case BuildLayout_Profiled: {
+      uint64_t *heats = kwgc_profile_heats(states_defragger.states, states_defragger.states_len, head_indexes, profile, dawg_start_state, gaddag_start_state, is_gaddag);
+      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, heats, is_gaddag, dawg_start_state);
+      free_tagged(AllocTag_Profile, heats, states_defragger.states_len * sizeof(uint64_t));
+      break;
+    }
+    case BuildLayout_Hot: {
+      uint64_t *heats = kwgc_hot_region_heats(states_defragger.states, states_defragger.states_len, head_indexes, num_ways, dawg_start_state, gaddag_start_state, is_gaddag);
+      kwgc_states_defragger_build_wolges(&states_defragger, num_ways, heats, is_gaddag, dawg_start_state);
+      free_tagged(AllocTag_Profile, heats, states_defragger.states_len * sizeof(uint64_t));
+      break;
+    }
+    case BuildLayout_Paged:
+      kwgc_states_defragger_build_paged(&states_defragger, num_ways, top_indexes, is_gaddag, dawg_start_state, gaddag_start_state);
       break;
   }
   destination[0] = 0; // useful for empty lexicon.
+  stats_end_phase(Phase_Defrag);
+  stats.states += state_maker.states.len;
   if (states_defragger.num_written > 0x1000000) {
     // the format can only have 0x1000000 elements, each has 4 bytes
     fprintf(stderr, "this format cannot have %u nodes\n", states_defragger.num_written);
-    free(destination);
-    free(to_end_lens);
-    free(head_indexes);
+    free_tagged(AllocTag_TopIndexes, top_indexes, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_NumWays, num_ways, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_Destination, destination, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_ToEndLens, to_end_lens, state_maker.states.len * sizeof(uint32_t));
+    free_tagged(AllocTag_HeadIndexes, head_indexes, state_maker.states.len * sizeof(uint32_t));
     kwgc_state_maker_free(&state_maker);
     return;
   }
@@ -1046,34 +1831,200 @@ void kbwgc_build(VecU32 *ret, Wordlist sorted_machine_words[static 1], bool is_g
       }
     }
   }
-  free(top_indexes);
-  free(num_ways);
-  free(destination);
-  free(to_end_lens);
-  free(head_indexes);
+  stats.nodes_written += ret->len;
+  // real nodes are never all zero.
+  for (uint32_t i = 0; i < ret->len; ++i) stats.gap_nodes += !ret->ptr[i];
+  if (sidecars && !kwgc_sidecars_fill(sidecars, states_defragger.states, states_defragger.states_len, destination, (uint32_t)ret->len)) ret->len = 0;
+  stats_end_phase(Phase_Emit);
+#ifdef KHM_INSTRUMENT
+  khmKwgcStateU32_fprint_instrument(stderr, &state_maker.states_finder);
+#endif
+  free_tagged(AllocTag_TopIndexes, top_indexes, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_NumWays, num_ways, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_Destination, destination, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_ToEndLens, to_end_lens, state_maker.states.len * sizeof(uint32_t));
+  free_tagged(AllocTag_HeadIndexes, head_indexes, state_maker.states.len * sizeof(uint32_t));
   kwgc_state_maker_free(&state_maker);
 }
 
+// sidecars
+
+// optional files written next to the output as outfile.<ext>, little-endian like the output.
+// they are derived from the output, which stays the same with or without them.
+
+// writes len elements of elt_size bytes from ptr to outfile.ext.
+bool write_sidecar(const char outfile[static 1], const char ext[static 1], const void *ptr, size_t elt_size, size_t len) {
+  bool errored = false;
+  bool defer_fclose = false;
+  size_t path_size = strlen(outfile) + strlen(ext) + 2;
+  char *path = malloc_or_die(path_size);
+  snprintf(path, path_size, "%s.%s", outfile, ext);
+  FILE *f = fopen(path, "wb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
+  if (fwrite(ptr, elt_size, len, f) != len) { perror("fwrite"); goto errored; }
+  defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  free(path);
+  return !errored;
+}
+
+// these byte-swap ptr in place on big-endian machines.
+
+bool write_sidecar_u32(const char outfile[static 1], const char ext[static 1], uint32_t *ptr, size_t len) {
+  if (is_big_endian()) for (size_t i = 0; i < len; ++i) ptr[i] = __builtin_bswap32(ptr[i]);
+  return write_sidecar(outfile, ext, ptr, sizeof(uint32_t), len);
+}
+
+bool write_sidecar_u64(const char outfile[static 1], const char ext[static 1], uint64_t *ptr, size_t len) {
+  if (is_big_endian()) for (size_t i = 0; i < len; ++i) ptr[i] = __builtin_bswap64(ptr[i]);
+  return write_sidecar(outfile, ext, ptr, sizeof(uint64_t), len);
+}
+
+// writes the per-node sidecars that were filled in.
+// outfile.cmask is the child masks, one uint64_t per node. see child_mask_seek in nodes.c.
+// outfile.hooks is two uint64_t per node. see hook_masks_at in nodes.c.
+// outfile.lens is the completion lengths, one uint32_t per node. see length_mask_within in nodes.c.
+// outfile.counts is the word counts, one uint32_t per node. see kwg_word_rank in nodes.c.
+bool write_node_sidecars(const char outfile[static 1], KwgcSidecars sidecars[static 1]) {
+  if (sidecar_child_masks && !write_sidecar_u64(outfile, "cmask", sidecars->child_masks.ptr, sidecars->child_masks.len)) return false;
+  if (sidecar_hooks && !write_sidecar_u64(outfile, "hooks", sidecars->hooks.ptr, sidecars->hooks.len)) return false;
+  if (sidecar_lengths && !write_sidecar_u32(outfile, "lens", sidecars->lengths.ptr, sidecars->lengths.len)) return false;
+  if (sidecar_counts && !write_sidecar_u32(outfile, "counts", sidecars->counts.ptr, sidecars->counts.len)) return false;
+  return true;
+}
+
+// outfile.jump is num_roots, depth, num_tiles, then per root (dawg, then gaddag) and per prefix length k
+// from 1 to depth, num_tiles^k entries indexed by the prefix's tiles as base num_tiles digits, first tile first.
+// each entry is the index of the node for the prefix's last tile (its p is the prefix's child list),
+// or 0 if no word starts with that prefix. see jump_seek in nodes.c.
+bool write_jump_sidecar(const char outfile[static 1], const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg, bool is_gaddag, uint32_t depth) {
+  uint32_t num_roots = is_gaddag ? 2 : 1;
+  uint32_t num_tiles = 1;
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    uint8_t c = layout_node_c(node_at(nodes, i), is_kbwg);
+    if (c >= num_tiles) num_tiles = c + 1u;
+  }
+  size_t per_root = 0;
+  for (size_t k = 1, level_len = 1; k <= depth; ++k) {
+    level_len *= num_tiles;
+    per_root += level_len;
+    if (per_root * num_roots > SIDECAR_MAX_JUMP_ENTRIES) {
+      fprintf(stderr, "jump table of depth %u for %u tiles is too big\n", depth, num_tiles);
+      return false;
+    }
+  }
+  size_t table_len = 3 + per_root * num_roots;
+  uint32_t *table = malloc_tagged_or_die(AllocTag_Sidecar, table_len * sizeof(uint32_t));
+  memset(table, 0, table_len * sizeof(uint32_t));
+  table[0] = num_roots;
+  table[1] = depth;
+  table[2] = num_tiles;
+  uint32_t *level = table + 3;
+  for (uint32_t r = 0; r < num_roots; ++r) {
+    // each level extends the previous one's prefixes, the root is the only prefix of length 0.
+    uint32_t *prev_level = NULL;
+    size_t prev_level_len = 1;
+    for (uint32_t k = 1; k <= depth; ++k) {
+      for (size_t j = 0; j < prev_level_len; ++j) {
+        if (prev_level && !prev_level[j]) continue;
+        uint32_t parent = prev_level ? prev_level[j] : r;
+        for (uint32_t p = layout_node_p(node_at(nodes, parent), is_kbwg); p > 0; ++p) {
+          uint32_t node = node_at(nodes, p);
+          level[j * num_tiles + layout_node_c(node, is_kbwg)] = p;
+          if (layout_node_e(node, is_kbwg)) break;
+        }
+      }
+      prev_level = level;
+      level += prev_level_len * num_tiles;
+      prev_level_len *= num_tiles;
+    }
+  }
+  bool ok = write_sidecar_u32(outfile, "jump", table, table_len);
+  free_tagged(AllocTag_Sidecar, table, table_len * sizeof(uint32_t));
+  return ok;
+}
+
 // commands
 
+// reads a profile for the profiled layout: one word per line, optionally followed by a comma or space and a count.
+// a lookup trace (one word per line per lookup) also works, repeated words add up.
+// mode as in do_lang_kwg (2 sorts the tiles), or 3 for klv2 leaves (sorted, blanks allowed).
+bool layout_profile_load(LayoutProfile ret[static 1], const char path[static 1], ParsedTile tileset_parse(uint8_t *), int mode) {
+  bool errored = false;
+  bool defer_fclose = false;
+  bool defer_free_file_content = false;
+  FILE *f = fopen(path, "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
+  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
+  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
+  size_t file_size = (size_t)file_size_signed;
+  size_t file_content_size = file_size + 1;
+  uint8_t *file_content = malloc_tagged_or_die(AllocTag_FileContent, file_content_size); defer_free_file_content = true;
+  rewind(f);
+  if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
+  defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  file_content[file_size++] = '\n'; // sentinel
+  OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
+  for (size_t i = 0; i < file_size; ) {
+    ParsedTile parsed_tile = tileset_parse(file_content + i);
+    if (parsed_tile.len && (parsed_tile.index > 0 || mode == 3)) {
+      vecByte_push(&ret->words.tiles_bytes, &parsed_tile.index);
+      i += parsed_tile.len;
+      ++cur_ofs_len.len;
+    } else if (file_content[i] == ',' || file_content[i] <= ' ') {
+      size_t orig_i = i;
+      bool has_count = file_content[i] != '\n';
+      while (file_content[i] != '\n') ++i;
+      file_content[i] = '\0'; // prevent sscanf from crashing
+      uint64_t weight = 1;
+      if (has_count && sscanf((char *)(file_content + orig_i + 1), "%" SCNu64, &weight) == 0) {
+        fprintf(stderr, "bad count at offset %zu\n", orig_i + 1);
+        goto errored;
+      }
+      ++i; // skip the newline
+      if (cur_ofs_len.len > 0) {
+        if (mode >= 2) qsort(ret->words.tiles_bytes.ptr + cur_ofs_len.ofs, cur_ofs_len.len, sizeof(uint8_t), qc_chr_cmp);
+        vecOfsLen_push(&ret->words.tiles_slices, &cur_ofs_len);
+        vecU64_push(&ret->weights, &weight);
+        cur_ofs_len.ofs += cur_ofs_len.len;
+        cur_ofs_len.len = 0;
+      }
+    } else {
+      fprintf(stderr, "bad tile at offset %zu\n", i);
+      goto errored;
+    }
+  }
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_free_file_content) free_tagged(AllocTag_FileContent, file_content, file_content_size);
+  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  return !errored;
+}
+
 bool do_lang_kwg(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout build_layout, int mode) {
   // assume argc >= 4. mode in [0 (dawgonly), 1 (gaddawg), 2 (alpha)].
   bool errored = false;
   bool defer_fclose = false;
   bool defer_free_file_content = false;
   bool defer_free_wl = false;
+  bool defer_free_profile = false;
   bool defer_free_ret = false;
+  bool defer_free_sidecars = false;
   FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
   if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
   off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
   size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size + 1); defer_free_file_content = true;
+  size_t file_content_size = file_size + 1;
+  uint8_t *file_content = malloc_tagged_or_die(AllocTag_FileContent, file_content_size); defer_free_file_content = true;
   rewind(f);
   if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
   file_content[file_size++] = '\n'; // sentinel
+  stats_end_phase(Phase_Read);
   OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
-  Wordlist wl = wordlist_new(); defer_free_wl = true;
+  Wordlist wl = wordlist_new(AllocTag_Words); defer_free_wl = true;
   for (size_t i = 0; i < file_size; ) {
     ParsedTile parsed_tile = tileset_parse(file_content + i);
     if (parsed_tile.len && parsed_tile.index > 0) { // ignore blank
@@ -1094,21 +2045,35 @@ bool do_lang_kwg(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout b
       goto errored;
     }
   }
-  defer_free_file_content = false; free(file_content);
+  defer_free_file_content = false; free_tagged(AllocTag_FileContent, file_content, file_content_size);
+  stats_end_phase(Phase_Tokenize);
   wordlist_sort(&wl);
+  stats_end_phase(Phase_Sort);
   wordlist_dedup(&wl);
-  VecU32 ret = vecU32_new(); defer_free_ret = true;
-  kwgc_build(&ret, &wl, mode == 1, build_layout);
+  stats_end_phase(Phase_Dedup);
+  LayoutProfile profile = layout_profile_new(); defer_free_profile = true;
+  if (build_layout == BuildLayout_Profiled) {
+    if (!layout_profile_load(&profile, argv[4], tileset_parse, mode)) goto errored;
+    stats_end_phase(Phase_Tokenize);
+  }
+  VecU32 ret = vecU32_new_tagged(AllocTag_Output); defer_free_ret = true;
+  KwgcSidecars sidecars = kwgc_sidecars_new(); defer_free_sidecars = true;
+  kwgc_build(&ret, &wl, mode == 1, build_layout, &profile, &sidecars);
   if (!ret.len) goto errored;
   f = fopen(argv[3], "wb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
   if (fwrite(ret.ptr, sizeof(uint32_t), ret.len, f) != ret.len) { perror("fwrite"); goto errored; }
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  if (sidecar_jump_depth && !write_jump_sidecar(argv[3], ret.ptr, (uint32_t)ret.len, false, mode == 1, sidecar_jump_depth)) goto errored;
+  if (!write_node_sidecars(argv[3], &sidecars)) goto errored;
+  stats_end_phase(Phase_Write);
   goto cleanup;
 errored: errored = true;
 cleanup:
+  if (defer_free_sidecars) kwgc_sidecars_free(&sidecars);
   if (defer_free_ret) vecU32_free(&ret);
+  if (defer_free_profile) layout_profile_free(&profile);
   if (defer_free_wl) wordlist_free(&wl);
-  if (defer_free_file_content) free(file_content);
+  if (defer_free_file_content) free_tagged(AllocTag_FileContent, file_content, file_content_size);
   if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
   return !errored;
 }
@@ -1119,18 +2084,22 @@ bool do_lang_kbwg(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout
   bool defer_fclose = false;
   bool defer_free_file_content = false;
   bool defer_free_wl = false;
+  bool defer_free_profile = false;
   bool defer_free_ret = false;
+  bool defer_free_sidecars = false;
   FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
   if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
   off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
   size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size + 1); defer_free_file_content = true;
+  size_t file_content_size = file_size + 1;
+  uint8_t *file_content = malloc_tagged_or_die(AllocTag_FileContent, file_content_size); defer_free_file_content = true;
   rewind(f);
   if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
   file_content[file_size++] = '\n'; // sentinel
+  stats_end_phase(Phase_Read);
   OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
-  Wordlist wl = wordlist_new(); defer_free_wl = true;
+  Wordlist wl = wordlist_new(AllocTag_Words); defer_free_wl = true;
   for (size_t i = 0; i < file_size; ) {
     ParsedTile parsed_tile = tileset_parse(file_content + i);
     if (parsed_tile.len && parsed_tile.index > 0) { // ignore blank
@@ -1151,48 +2120,62 @@ bool do_lang_kbwg(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout
       goto errored;
     }
   }
-  defer_free_file_content = false; free(file_content);
+  defer_free_file_content = false; free_tagged(AllocTag_FileContent, file_content, file_content_size);
+  stats_end_phase(Phase_Tokenize);
   wordlist_sort(&wl);
+  stats_end_phase(Phase_Sort);
   wordlist_dedup(&wl);
-  VecU32 ret = vecU32_new(); defer_free_ret = true;
-  kbwgc_build(&ret, &wl, mode == 1, build_layout);
+  stats_end_phase(Phase_Dedup);
+  LayoutProfile profile = layout_profile_new(); defer_free_profile = true;
+  if (build_layout == BuildLayout_Profiled) {
+    if (!layout_profile_load(&profile, argv[4], tileset_parse, mode)) goto errored;
+    stats_end_phase(Phase_Tokenize);
+  }
+  VecU32 ret = vecU32_new_tagged(AllocTag_Output); defer_free_ret = true;
+  KwgcSidecars sidecars = kwgc_sidecars_new(); defer_free_sidecars = true;
+  kbwgc_build(&ret, &wl, mode == 1, build_layout, &profile, &sidecars);
   if (!ret.len) goto errored;
   f = fopen(argv[3], "wb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
   if (fwrite(ret.ptr, sizeof(uint32_t), ret.len, f) != ret.len) { perror("fwrite"); goto errored; }
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  if (sidecar_jump_depth && !write_jump_sidecar(argv[3], ret.ptr, (uint32_t)ret.len, true, mode == 1, sidecar_jump_depth)) goto errored;
+  if (!write_node_sidecars(argv[3], &sidecars)) goto errored;
+  stats_end_phase(Phase_Write);
   goto cleanup;
 errored: errored = true;
 cleanup:
+  if (defer_free_sidecars) kwgc_sidecars_free(&sidecars);
   if (defer_free_ret) vecU32_free(&ret);
+  if (defer_free_profile) layout_profile_free(&profile);
   if (defer_free_wl) wordlist_free(&wl);
-  if (defer_free_file_content) free(file_content);
+  if (defer_free_file_content) free_tagged(AllocTag_FileContent, file_content, file_content_size);
   if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
   return !errored;
 }
 
-bool do_lang_klv2(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout build_layout) {
+// reads a leaves csv (rack,value lines) into ret, each rack with its tiles sorted and
+// followed by the value as 4 little-endian bytes, then sorts and dedups.
+bool klv_csv_load(Wordlist ret[static 1], const char path[static 1], ParsedTile tileset_parse(uint8_t *)) {
   bool errored = false;
   bool defer_fclose = false;
   bool defer_free_file_content = false;
-  bool defer_free_wl = false;
-  bool defer_free_ret = false;
-  bool defer_free_out = false;
-  FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
+  FILE *f = fopen(path, "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
   if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
   off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
   size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size + 1); defer_free_file_content = true;
+  size_t file_content_size = file_size + 1;
+  uint8_t *file_content = malloc_tagged_or_die(AllocTag_FileContent, file_content_size); defer_free_file_content = true;
   rewind(f);
   if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
   file_content[file_size++] = '\n'; // sentinel
+  stats_end_phase(Phase_Read);
   OfsLen cur_ofs_len = { .ofs = 0, .len = 0 };
-  Wordlist wl = wordlist_new(); defer_free_wl = true;
   bool this_is_big_endian = is_big_endian();
   for (size_t i = 0; i < file_size; ) {
     ParsedTile parsed_tile = tileset_parse(file_content + i);
     if (parsed_tile.len) { // allow blank
-      vecByte_push(&wl.tiles_bytes, &parsed_tile.index);
+      vecByte_push(&ret->tiles_bytes, &parsed_tile.index);
       i += parsed_tile.len;
       ++cur_ofs_len.len;
     } else if (file_content[i] == ',') {
@@ -1206,19 +2189,19 @@ bool do_lang_klv2(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout
       }
       ++i; // skip the newline
       if (cur_ofs_len.len > 0) {
-        qsort(wl.tiles_bytes.ptr + cur_ofs_len.ofs, cur_ofs_len.len, sizeof(uint8_t), qc_chr_cmp);
+        qsort(ret->tiles_bytes.ptr + cur_ofs_len.ofs, cur_ofs_len.len, sizeof(uint8_t), qc_chr_cmp);
         if (this_is_big_endian) {
-          vecByte_push(&wl.tiles_bytes, ((uint8_t *)&val) + 3);
-          vecByte_push(&wl.tiles_bytes, ((uint8_t *)&val) + 2);
-          vecByte_push(&wl.tiles_bytes, ((uint8_t *)&val) + 1);
-          vecByte_push(&wl.tiles_bytes, (uint8_t *)&val);
+          vecByte_push(&ret->tiles_bytes, ((uint8_t *)&val) + 3);
+          vecByte_push(&ret->tiles_bytes, ((uint8_t *)&val) + 2);
+          vecByte_push(&ret->tiles_bytes, ((uint8_t *)&val) + 1);
+          vecByte_push(&ret->tiles_bytes, (uint8_t *)&val);
         } else {
-          vecByte_push(&wl.tiles_bytes, (uint8_t *)&val);
-          vecByte_push(&wl.tiles_bytes, ((uint8_t *)&val) + 1);
-          vecByte_push(&wl.tiles_bytes, ((uint8_t *)&val) + 2);
-          vecByte_push(&wl.tiles_bytes, ((uint8_t *)&val) + 3);
+          vecByte_push(&ret->tiles_bytes, (uint8_t *)&val);
+          vecByte_push(&ret->tiles_bytes, ((uint8_t *)&val) + 1);
+          vecByte_push(&ret->tiles_bytes, ((uint8_t *)&val) + 2);
+          vecByte_push(&ret->tiles_bytes, ((uint8_t *)&val) + 3);
         }
-        vecOfsLen_push(&wl.tiles_slices, &cur_ofs_len);
+        vecOfsLen_push(&ret->tiles_slices, &cur_ofs_len);
         cur_ofs_len.ofs += cur_ofs_len.len + 4; // sizeof(float)
         cur_ofs_len.len = 0;
       }
@@ -1230,14 +2213,40 @@ bool do_lang_klv2(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout
       goto errored;
     }
   }
-  defer_free_file_content = false; free(file_content);
-  wordlist_sort(&wl);
-  wordlist_dedup(&wl);
-  VecU32 ret = vecU32_new(); defer_free_ret = true;
-  kwgc_build(&ret, &wl, false, build_layout);
+  defer_free_file_content = false; free_tagged(AllocTag_FileContent, file_content, file_content_size);
+  stats_end_phase(Phase_Tokenize);
+  wordlist_sort(ret);
+  stats_end_phase(Phase_Sort);
+  wordlist_dedup(ret);
+  stats_end_phase(Phase_Dedup);
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_free_file_content) free_tagged(AllocTag_FileContent, file_content, file_content_size);
+  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  return !errored;
+}
+
+bool do_lang_klv2(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout build_layout) {
+  bool errored = false;
+  bool defer_fclose = false;
+  bool defer_free_wl = false;
+  bool defer_free_profile = false;
+  bool defer_free_ret = false;
+  bool defer_free_out = false;
+  FILE *f = NULL;
+  Wordlist wl = wordlist_new(AllocTag_Words); defer_free_wl = true;
+  if (!klv_csv_load(&wl, argv[2], tileset_parse)) goto errored;
+  LayoutProfile profile = layout_profile_new(); defer_free_profile = true;
+  if (build_layout == BuildLayout_Profiled) {
+    if (!layout_profile_load(&profile, argv[4], tileset_parse, 3)) goto errored;
+    stats_end_phase(Phase_Tokenize);
+  }
+  VecU32 ret = vecU32_new_tagged(AllocTag_Output); defer_free_ret = true;
+  kwgc_build(&ret, &wl, false, build_layout, &profile, NULL);
   if (!ret.len) goto errored;
   size_t out_len = ret.len + wl.tiles_slices.len + 2;
-  uint8_t *out = malloc_or_die(out_len * sizeof(uint32_t)); defer_free_out = true;
+  uint8_t *out = malloc_tagged_or_die(AllocTag_Output, out_len * sizeof(uint32_t)); defer_free_out = true;
   uint8_t *pout = out;
   *pout++ = ret.len;
   *pout++ = ret.len >> 8;
@@ -1260,213 +2269,1137 @@ bool do_lang_klv2(char **argv, ParsedTile tileset_parse(uint8_t *), BuildLayout
   f = fopen(argv[3], "wb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
   if (fwrite(out, sizeof(uint32_t), out_len, f) != out_len) { perror("fwrite"); goto errored; }
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  stats_end_phase(Phase_Write);
   goto cleanup;
 errored: errored = true;
 cleanup:
-  if (defer_free_out) free(out);
+  if (defer_free_out) free_tagged(AllocTag_Output, out, out_len * sizeof(uint32_t));
   if (defer_free_ret) vecU32_free(&ret);
+  if (defer_free_profile) layout_profile_free(&profile);
   if (defer_free_wl) wordlist_free(&wl);
-  if (defer_free_file_content) free(file_content);
   if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
   return !errored;
 }
 
-typedef struct { uint32_t p : 22; bool e : 1, d : 1; uint8_t c : 8; } KwgNode; // compiler-specific UB.
-
-void dump_kwg(KwgNode *kwg, VecChar *word, uint32_t p, Tile tileset[static 1]) {
-  size_t orig_len = word->len;
-  for (; p > 0; ++p) {
-    size_t label_len = strlen(tileset[kwg[p].c].label);
-    size_t len = orig_len + label_len;
-    vecChar_ensure_cap(word, len);
-    memcpy(word->ptr + orig_len, tileset[kwg[p].c].label, label_len);
-    word->len = len;
-    if (kwg[p].d) printf("%.*s\n", (int)len, word->ptr);
-    if (kwg[p].p) dump_kwg(kwg, word, kwg[p].p, tileset);
-    if (kwg[p].e) break;
-  }
-  word->len = orig_len;
-}
-
-bool do_lang_rkwg(char **argv, Tile tileset[static 1]) {
-  // assume argc >= 3.
+bool do_lang_klv_dense(char **argv, ParsedTile tileset_parse(uint8_t *)) {
   bool errored = false;
   bool defer_fclose = false;
-  bool defer_free_file_content = false;
-  bool defer_free_word = false;
-  FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
-  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
-  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
-  size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size); defer_free_file_content = true;
-  rewind(f);
-  if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
-  if (is_big_endian()) swap_bytes_32(file_content, file_size);
-  KwgNode *kwg = (KwgNode *)file_content;
-  VecChar word = vecChar_new(); defer_free_word = true;
-  dump_kwg(kwg, &word, kwg[0].p, tileset);
+  bool defer_free_wl = false;
+  bool defer_free_out = false;
+  FILE *f = NULL;
+  Wordlist wl = wordlist_new(AllocTag_Words); defer_free_wl = true;
+  if (!klv_csv_load(&wl, argv[2], tileset_parse)) goto errored;
+  // the blank is always in the alphabet.
+  uint32_t alphabet_size = 1, max_len = 0;
+  for (size_t i = 0; i < wl.tiles_slices.len; ++i) {
+    OfsLen *this_word = &wl.tiles_slices.ptr[i];
+    if (this_word->len > max_len) max_len = (uint32_t)this_word->len;
+    // sorted, so the last tile is the largest.
+    uint8_t tile = wl.tiles_bytes.ptr[this_word->ofs + this_word->len - 1];
+    if (tile >= alphabet_size) alphabet_size = tile + 1u;
+  }
+  if (max_len > KLV_DENSE_MAX_LEN || alphabet_size > KLV_DENSE_MAX_ALPHABET) {
+    fprintf(stderr, "racks of %u tiles from %u are too long for a dense table\n", max_len, alphabet_size);
+    goto errored;
+  }
+  KlvDense shape;
+  klv_dense_init_shape(&shape, alphabet_size, max_len);
+  uint64_t num_racks = klv_dense_num_racks(&shape);
+  if (num_racks > KLV_DENSE_MAX_RACKS) {
+    fprintf(stderr, "%" PRIu64 " racks are too many for a dense table\n", num_racks);
+    goto errored;
+  }
+  size_t out_len = num_racks + 2;
+  uint8_t *out = malloc_tagged_or_die(AllocTag_Output, out_len * sizeof(uint32_t)); defer_free_out = true;
+  // racks not in the csv stay missing.
+  for (size_t i = 2 * sizeof(uint32_t); i < out_len * sizeof(uint32_t); i += sizeof(uint32_t)) {
+    out[i] = (uint8_t)KLV_DENSE_MISSING;
+    out[i + 1] = (uint8_t)(KLV_DENSE_MISSING >> 8);
+    out[i + 2] = (uint8_t)(KLV_DENSE_MISSING >> 16);
+    out[i + 3] = (uint8_t)(KLV_DENSE_MISSING >> 24);
+  }
+  uint8_t *pout = out;
+  *pout++ = alphabet_size;
+  *pout++ = alphabet_size >> 8;
+  *pout++ = alphabet_size >> 16;
+  *pout++ = alphabet_size >> 24;
+  *pout++ = max_len;
+  *pout++ = max_len >> 8;
+  *pout++ = max_len >> 16;
+  *pout++ = max_len >> 24;
+  for (size_t i = 0; i < wl.tiles_slices.len; ++i) {
+    OfsLen *this_word = &wl.tiles_slices.ptr[i];
+    uint8_t *p = &wl.tiles_bytes.ptr[this_word->ofs];
+    uint64_t rack_index = klv_dense_index(&shape, p, this_word->len);
+    memcpy(pout + rack_index * sizeof(uint32_t), p + this_word->len, sizeof(uint32_t)); // already little-endian.
+  }
+  stats_end_phase(Phase_Emit);
+  f = fopen(argv[3], "wb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
+  if (fwrite(out, sizeof(uint32_t), out_len, f) != out_len) { perror("fwrite"); goto errored; }
+  defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  stats_end_phase(Phase_Write);
   goto cleanup;
 errored: errored = true;
 cleanup:
-  if (defer_free_word) vecChar_free(&word);
-  if (defer_free_file_content) free(file_content);
+  if (defer_free_out) free_tagged(AllocTag_Output, out, out_len * sizeof(uint32_t));
+  if (defer_free_wl) wordlist_free(&wl);
   if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
   return !errored;
 }
 
-bool do_lang_rkwg_gaddag(char **argv, Tile tileset[static 1]) {
-  // assume argc >= 3.
-  bool errored = false;
-  bool defer_fclose = false;
-  bool defer_free_file_content = false;
-  bool defer_free_word = false;
-  FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
-  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
-  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
-  size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size); defer_free_file_content = true;
-  rewind(f);
-  if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
-  if (is_big_endian()) swap_bytes_32(file_content, file_size);
-  KwgNode *kwg = (KwgNode *)file_content;
-  VecChar word = vecChar_new(); defer_free_word = true;
-  dump_kwg(kwg, &word, kwg[1].p, tileset);
+// output writer
+
+// large user-space buffer, flushed with write(2) instead of going through stdio.
+// fd < 0 only accumulates, the caller writes out the buffer later.
+typedef struct {
+  VecChar buf;
+  int fd;
+  bool errored;
+} OutWriter;
+
+#define OUT_WRITER_FLUSH_LEN ((size_t)1 << 20)
+
+static inline OutWriter out_writer_new(int fd) {
+  OutWriter ret = {
+    .buf = vecChar_new(),
+    .fd = fd,
+    .errored = false,
+  };
+  if (fd >= 0) vecChar_ensure_cap_exact(&ret.buf, OUT_WRITER_FLUSH_LEN << 1);
+  return ret;
+}
+
+bool write_all(int fd, const char *ptr, size_t len) {
+  while (len) {
+    ssize_t num_written = write(fd, ptr, len);
+    if (num_written < 0) {
+      if (errno == EINTR) continue;
+      perror("write");
+      return false;
+    }
+    ptr += num_written;
+    len -= (size_t)num_written;
+  }
+  return true;
+}
+
+static inline void out_writer_flush(OutWriter self[static 1]) {
+  if (self->fd >= 0 && self->buf.len) {
+    if (!self->errored && !write_all(self->fd, self->buf.ptr, self->buf.len)) self->errored = true;
+    self->buf.len = 0;
+  }
+}
+
+static inline void out_writer_write(OutWriter self[static 1], const char *ptr, size_t len) {
+  vecChar_ensure_cap(&self->buf, self->buf.len + len);
+  memcpy(self->buf.ptr + self->buf.len, ptr, len);
+  self->buf.len += len;
+  if (self->buf.len >= OUT_WRITER_FLUSH_LEN) out_writer_flush(self);
+}
+
+// writes ptr[0..len] and a newline.
+static inline void out_writer_write_line(OutWriter self[static 1], const char *ptr, size_t len) {
+  vecChar_ensure_cap(&self->buf, self->buf.len + len + 1);
+  memcpy(self->buf.ptr + self->buf.len, ptr, len);
+  self->buf.ptr[self->buf.len + len] = '\n';
+  self->buf.len += len + 1;
+  if (self->buf.len >= OUT_WRITER_FLUSH_LEN) out_writer_flush(self);
+}
+
+// flushes and frees. returns false if any write failed.
+static inline bool out_writer_free(OutWriter self[static 1]) {
+  out_writer_flush(self);
+  vecChar_free(&self->buf);
+  return !self->errored;
+}
+
+// verifiers
+
+// these report and return false if the file fails the structural checks in nodes.c.
+
+bool report_kwg_verify(const uint32_t *kwg, size_t file_size, bool is_gaddag) {
+  uint32_t bad_index;
+  const char *err = kwg_verify(kwg, (uint32_t)(file_size / sizeof(uint32_t)), is_gaddag, &bad_index);
+  if (err) fprintf(stderr, "invalid kwg at node %u: %s\n", bad_index, err);
+  return !err;
+}
+
+bool report_kbwg_verify(const uint32_t *kbwg, size_t file_size, bool is_gaddag) {
+  uint32_t bad_index;
+  const char *err = kbwg_verify(kbwg, (uint32_t)(file_size / sizeof(uint32_t)), is_gaddag, &bad_index);
+  if (err) fprintf(stderr, "invalid kbwg at node %u: %s\n", bad_index, err);
+  return !err;
+}
+
+bool report_klv2_verify(const uint32_t *klv2, size_t file_size) {
+  uint32_t bad_index;
+  const char *err = klv2_verify(klv2, file_size / sizeof(uint32_t), &bad_index);
+  if (err) fprintf(stderr, "invalid klv2 at node %u: %s\n", bad_index, err);
+  return !err;
+}
+
+bool report_klv_dense_verify(const uint32_t *kld, size_t file_size) {
+  const char *err = klv_dense_verify(kld, file_size / sizeof(uint32_t));
+  if (err) fprintf(stderr, "invalid dense leave table: %s\n", err);
+  return !err;
+}
+
+bool do_lang_verify(char **argv, int mode) {
+  // assume argc >= 3. mode in [0 (kwg dawgonly), 1 (kwg gaddawg), 2 (kbwg gaddawg), 3 (klv2)].
+  bool errored = false;
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *words = (const uint32_t *)file_content;
+  bool ok = mode == 3 ? report_klv2_verify(words, file_size) :
+    mode == 2 ? report_kbwg_verify(words, file_size, true) :
+    report_kwg_verify(words, file_size, mode == 1);
+  if (!ok) goto errored;
+  stats_end_phase(Phase_Verify);
+  printf("%s: ok, %zu nodes\n", argv[2], file_size / sizeof(uint32_t));
   goto cleanup;
 errored: errored = true;
 cleanup:
-  if (defer_free_word) vecChar_free(&word);
-  if (defer_free_file_content) free(file_content);
-  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
   return !errored;
 }
 
-typedef struct { uint8_t c : 6; bool e : 1, d : 1; uint32_t p : 24; } KbwgNode; // compiler-specific UB.
+// word dumper
 
-// same code, just changed kwg to kbwg.
+// places label at word[ofs..], returns the new length. word->len is not updated.
+static inline size_t word_put_label(VecChar word[static 1], size_t ofs, const char label[static 1]) {
+  size_t label_len = strlen(label);
+  vecChar_ensure_cap(word, ofs + label_len);
+  memcpy(word->ptr + ofs, label, label_len);
+  return ofs + label_len;
+}
+
+// one entry per sibling list being walked, instead of one C stack frame per node.
+typedef struct {
+  uint32_t p; // next node to visit in this sibling list.
+  size_t word_len; // length of the prefix before this sibling list.
+} DumpFrame;
+
+#define VEC_ELT_NAME DumpFrame
+#define VEC_ELT_T DumpFrame
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+// for -j, words under the root are split into jobs that are dumped concurrently and
+// concatenated in job order, which is the same order as the single-threaded dump.
+typedef struct {
+  uint32_t top; // a node in the root sibling list.
+  uint32_t p; // a child of top (dumps p and its descendants), or 0 (dumps top alone).
+} DumpJob;
+
+#define VEC_ELT_NAME DumpJob
+#define VEC_ELT_T DumpJob
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+typedef void DumpJobFunc(const void *nodes, Tile tileset[static 1], DumpJob job, OutWriter out[static 1]);
 
-void dump_kbwg(KbwgNode *kbwg, VecChar *word, uint32_t p, Tile tileset[static 1]) {
-  size_t orig_len = word->len;
+typedef struct {
+  const void *nodes;
+  Tile *tileset;
+  DumpJobFunc *dump_job;
+  DumpJob *jobs;
+  OutWriter *outs;
+  bool *dones;
+  size_t num_jobs;
+  atomic_size_t next_job;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} ParallelDumper;
+
+void *parallel_dumper_worker(void *arg) {
+  ParallelDumper *self = arg;
+  while (true) {
+    size_t i = atomic_fetch_add_explicit(&self->next_job, 1, memory_order_relaxed);
+    if (i >= self->num_jobs) break;
+    self->dump_job(self->nodes, self->tileset, self->jobs[i], &self->outs[i]);
+    pthread_mutex_lock(&self->mutex);
+    self->dones[i] = true;
+    pthread_cond_broadcast(&self->cond);
+    pthread_mutex_unlock(&self->mutex);
+  }
+  return NULL;
+}
+
+// runs jobs on num_threads threads, writes each job's output to out in order as soon as it is done.
+void parallel_dump(const void *nodes, Tile tileset[static 1], DumpJobFunc dump_job, VecDumpJob jobs[static 1], size_t num_threads, OutWriter out[static 1]) {
+  ParallelDumper dumper = {
+    .nodes = nodes,
+    .tileset = tileset,
+    .dump_job = dump_job,
+    .jobs = jobs->ptr,
+    .outs = malloc_or_die(jobs->len * sizeof(OutWriter)),
+    .dones = malloc_or_die(jobs->len * sizeof(bool)),
+    .num_jobs = jobs->len,
+  };
+  atomic_init(&dumper.next_job, 0);
+  pthread_mutex_init(&dumper.mutex, NULL);
+  pthread_cond_init(&dumper.cond, NULL);
+  for (size_t i = 0; i < jobs->len; ++i) {
+    dumper.outs[i] = out_writer_new(-1);
+    dumper.dones[i] = false;
+  }
+  if (num_threads > jobs->len) num_threads = jobs->len;
+  pthread_t *threads = malloc_or_die(num_threads * sizeof(pthread_t));
+  size_t num_started = 0;
+  for (; num_started < num_threads; ++num_started) {
+    int err = pthread_create(&threads[num_started], NULL, parallel_dumper_worker, &dumper);
+    if (err) {
+      fprintf(stderr, "pthread_create: %s\n", strerror(err));
+      break;
+    }
+  }
+  // with no threads, do everything here.
+  if (!num_started) parallel_dumper_worker(&dumper);
+  for (size_t i = 0; i < jobs->len; ++i) {
+    pthread_mutex_lock(&dumper.mutex);
+    while (!dumper.dones[i]) pthread_cond_wait(&dumper.cond, &dumper.mutex);
+    pthread_mutex_unlock(&dumper.mutex);
+    out_writer_write(out, dumper.outs[i].buf.ptr, dumper.outs[i].buf.len);
+    out_writer_free(&dumper.outs[i]);
+  }
+  for (size_t i = 0; i < num_started; ++i) pthread_join(threads[i], NULL);
+  free(threads);
+  pthread_cond_destroy(&dumper.cond);
+  pthread_mutex_destroy(&dumper.mutex);
+  free(dumper.dones);
+  free(dumper.outs);
+}
+
+// word->len is the prefix length.
+void dump_kwg(const uint32_t *kwg, VecChar *word, uint32_t p, Tile tileset[static 1], OutWriter out[static 1]) {
+  if (!p) return;
+  VecDumpFrame stack = vecDumpFrame_new();
+  vecDumpFrame_push(&stack, &(DumpFrame){ .p = p, .word_len = word->len });
+  while (stack.len) {
+    DumpFrame *frame = &stack.ptr[stack.len - 1];
+    p = frame->p;
+    uint32_t node = node_at(kwg, p);
+    size_t len = word_put_label(word, frame->word_len, tileset[kwg_node_c(node)].label);
+    // advance before pushing, which may move the frame.
+    if (kwg_node_e(node)) --stack.len; else ++frame->p;
+    if (kwg_node_d(node)) out_writer_write_line(out, word->ptr, len);
+    if (kwg_node_p(node)) vecDumpFrame_push(&stack, &(DumpFrame){ .p = kwg_node_p(node), .word_len = len });
+  }
+  vecDumpFrame_free(&stack);
+}
+
+void dump_kwg_jobs(const uint32_t *kwg, uint32_t p, VecDumpJob jobs[static 1]) {
   for (; p > 0; ++p) {
-    size_t label_len = strlen(tileset[kbwg[p].c].label);
-    size_t len = orig_len + label_len;
-    vecChar_ensure_cap(word, len);
-    memcpy(word->ptr + orig_len, tileset[kbwg[p].c].label, label_len);
-    word->len = len;
-    if (kbwg[p].d) printf("%.*s\n", (int)len, word->ptr);
-    if (kbwg[p].p) dump_kbwg(kbwg, word, kbwg[p].p, tileset);
-    if (kbwg[p].e) break;
+    uint32_t node = node_at(kwg, p);
+    vecDumpJob_push(jobs, &(DumpJob){ .top = p, .p = 0 });
+    for (uint32_t q = kwg_node_p(node); q > 0; ++q) {
+      vecDumpJob_push(jobs, &(DumpJob){ .top = p, .p = q });
+      if (kwg_node_e(node_at(kwg, q))) break;
+    }
+    if (kwg_node_e(node)) break;
   }
-  word->len = orig_len;
 }
 
-bool do_lang_rkbwg(char **argv, Tile tileset[static 1]) {
+void dump_kwg_job(const void *nodes, Tile tileset[static 1], DumpJob job, OutWriter out[static 1]) {
+  const uint32_t *kwg = nodes;
+  VecChar word = vecChar_new();
+  uint32_t node = node_at(kwg, job.top);
+  word.len = word_put_label(&word, 0, tileset[kwg_node_c(node)].label);
+  if (!job.p) {
+    if (kwg_node_d(node)) out_writer_write_line(out, word.ptr, word.len);
+  } else {
+    node = node_at(kwg, job.p);
+    word.len = word_put_label(&word, word.len, tileset[kwg_node_c(node)].label);
+    if (kwg_node_d(node)) out_writer_write_line(out, word.ptr, word.len);
+    dump_kwg(kwg, &word, kwg_node_p(node), tileset, out);
+  }
+  vecChar_free(&word);
+}
+
+void dump_kwg_root(const uint32_t *kwg, uint32_t p, Tile tileset[static 1], size_t num_threads, OutWriter out[static 1]) {
+  if (num_threads > 1) {
+    VecDumpJob jobs = vecDumpJob_new();
+    dump_kwg_jobs(kwg, p, &jobs);
+    parallel_dump(kwg, tileset, dump_kwg_job, &jobs, num_threads, out);
+    vecDumpJob_free(&jobs);
+  } else {
+    VecChar word = vecChar_new();
+    dump_kwg(kwg, &word, p, tileset, out);
+    vecChar_free(&word);
+  }
+}
+
+bool do_lang_rkwg(char **argv, Tile tileset[static 1], size_t num_threads) {
   // assume argc >= 3.
   bool errored = false;
-  bool defer_fclose = false;
-  bool defer_free_file_content = false;
-  bool defer_free_word = false;
-  FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
-  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
-  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
-  size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size); defer_free_file_content = true;
-  rewind(f);
-  if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
-  if (is_big_endian()) swap_bytes_32(file_content, file_size);
-  KbwgNode *kbwg = (KbwgNode *)file_content;
-  VecChar word = vecChar_new(); defer_free_word = true;
-  dump_kbwg(kbwg, &word, kbwg[0].p, tileset);
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *kwg = (const uint32_t *)file_content;
+  if (!report_kwg_verify(kwg, file_size, false)) goto errored;
+  stats_end_phase(Phase_Verify);
+  OutWriter out = out_writer_new(STDOUT_FILENO);
+  dump_kwg_root(kwg, kwg_node_p(node_at(kwg, 0)), tileset, num_threads, &out);
+  if (!out_writer_free(&out)) goto errored;
+  stats_end_phase(Phase_Dump);
   goto cleanup;
 errored: errored = true;
 cleanup:
-  if (defer_free_word) vecChar_free(&word);
-  if (defer_free_file_content) free(file_content);
-  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
   return !errored;
 }
 
-bool do_lang_rkbwg_gaddag(char **argv, Tile tileset[static 1]) {
+bool do_lang_rkwg_gaddag(char **argv, Tile tileset[static 1], size_t num_threads) {
   // assume argc >= 3.
   bool errored = false;
-  bool defer_fclose = false;
-  bool defer_free_file_content = false;
-  bool defer_free_word = false;
-  FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
-  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
-  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
-  size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size); defer_free_file_content = true;
-  rewind(f);
-  if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
-  if (is_big_endian()) swap_bytes_32(file_content, file_size);
-  KbwgNode *kbwg = (KbwgNode *)file_content;
-  VecChar word = vecChar_new(); defer_free_word = true;
-  dump_kbwg(kbwg, &word, kbwg[1].p, tileset);
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *kwg = (const uint32_t *)file_content;
+  if (!report_kwg_verify(kwg, file_size, true)) goto errored;
+  stats_end_phase(Phase_Verify);
+  OutWriter out = out_writer_new(STDOUT_FILENO);
+  dump_kwg_root(kwg, kwg_node_p(node_at(kwg, 1)), tileset, num_threads, &out);
+  if (!out_writer_free(&out)) goto errored;
+  stats_end_phase(Phase_Dump);
   goto cleanup;
 errored: errored = true;
 cleanup:
-  if (defer_free_word) vecChar_free(&word);
-  if (defer_free_file_content) free(file_content);
-  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
   return !errored;
 }
 
-void dump_klv2(KwgNode *kwg, VecChar *word, uint32_t p, Tile tileset[static 1], float **klv_ptr) {
-  size_t orig_len = word->len;
+// same code, just changed kwg to kbwg.
+
+void dump_kbwg(const uint32_t *kbwg, VecChar *word, uint32_t p, Tile tileset[static 1], OutWriter out[static 1]) {
+  if (!p) return;
+  VecDumpFrame stack = vecDumpFrame_new();
+  vecDumpFrame_push(&stack, &(DumpFrame){ .p = p, .word_len = word->len });
+  while (stack.len) {
+    DumpFrame *frame = &stack.ptr[stack.len - 1];
+    p = frame->p;
+    uint32_t node = node_at(kbwg, p);
+    size_t len = word_put_label(word, frame->word_len, tileset[kbwg_node_c(node)].label);
+    // advance before pushing, which may move the frame.
+    if (kbwg_node_e(node)) --stack.len; else ++frame->p;
+    if (kbwg_node_d(node)) out_writer_write_line(out, word->ptr, len);
+    if (kbwg_node_p(node)) vecDumpFrame_push(&stack, &(DumpFrame){ .p = kbwg_node_p(node), .word_len = len });
+  }
+  vecDumpFrame_free(&stack);
+}
+
+void dump_kbwg_jobs(const uint32_t *kbwg, uint32_t p, VecDumpJob jobs[static 1]) {
   for (; p > 0; ++p) {
-    size_t label_len = strlen(tileset[kwg[p].c].label);
-    size_t len = orig_len + label_len;
-    vecChar_ensure_cap(word, len);
-    memcpy(word->ptr + orig_len, tileset[kwg[p].c].label, label_len);
-    word->len = len;
-    if (kwg[p].d) {
-      // find the required precision between 1 and 16.
-      char s[128];
-      float check;
-#define precision_le(n, t, f) (((snprintf(s, sizeof(s), "%." #n "f", **klv_ptr), sscanf(s, "%f", &check)) == 1 && check == **klv_ptr) ? t : f)
-      int precision = precision_le(8,
-        precision_le(4,
-          precision_le(2, precision_le(1, 1, 2), precision_le(3, 3, 4)),
-          precision_le(6, precision_le(5, 5, 6), precision_le(7, 7, 8))),
-        precision_le(12,
-          precision_le(10, precision_le(9, 9, 10), precision_le(11, 11, 12)),
-          precision_le(14, precision_le(13, 13, 14), precision_le(15, 15, 16))));
-      printf("%.*s,%.*f\n", (int)len, word->ptr, precision, *(*klv_ptr)++);
+    uint32_t node = node_at(kbwg, p);
+    vecDumpJob_push(jobs, &(DumpJob){ .top = p, .p = 0 });
+    for (uint32_t q = kbwg_node_p(node); q > 0; ++q) {
+      vecDumpJob_push(jobs, &(DumpJob){ .top = p, .p = q });
+      if (kbwg_node_e(node_at(kbwg, q))) break;
     }
-    if (kwg[p].p) dump_klv2(kwg, word, kwg[p].p, tileset, klv_ptr);
-    if (kwg[p].e) break;
+    if (kbwg_node_e(node)) break;
   }
-  word->len = orig_len;
+}
+
+void dump_kbwg_job(const void *nodes, Tile tileset[static 1], DumpJob job, OutWriter out[static 1]) {
+  const uint32_t *kbwg = nodes;
+  VecChar word = vecChar_new();
+  uint32_t node = node_at(kbwg, job.top);
+  word.len = word_put_label(&word, 0, tileset[kbwg_node_c(node)].label);
+  if (!job.p) {
+    if (kbwg_node_d(node)) out_writer_write_line(out, word.ptr, word.len);
+  } else {
+    node = node_at(kbwg, job.p);
+    word.len = word_put_label(&word, word.len, tileset[kbwg_node_c(node)].label);
+    if (kbwg_node_d(node)) out_writer_write_line(out, word.ptr, word.len);
+    dump_kbwg(kbwg, &word, kbwg_node_p(node), tileset, out);
+  }
+  vecChar_free(&word);
+}
+
+void dump_kbwg_root(const uint32_t *kbwg, uint32_t p, Tile tileset[static 1], size_t num_threads, OutWriter out[static 1]) {
+  if (num_threads > 1) {
+    VecDumpJob jobs = vecDumpJob_new();
+    dump_kbwg_jobs(kbwg, p, &jobs);
+    parallel_dump(kbwg, tileset, dump_kbwg_job, &jobs, num_threads, out);
+    vecDumpJob_free(&jobs);
+  } else {
+    VecChar word = vecChar_new();
+    dump_kbwg(kbwg, &word, p, tileset, out);
+    vecChar_free(&word);
+  }
+}
+
+bool do_lang_rkbwg(char **argv, Tile tileset[static 1], size_t num_threads) {
+  // assume argc >= 3.
+  bool errored = false;
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *kbwg = (const uint32_t *)file_content;
+  if (!report_kbwg_verify(kbwg, file_size, false)) goto errored;
+  stats_end_phase(Phase_Verify);
+  OutWriter out = out_writer_new(STDOUT_FILENO);
+  dump_kbwg_root(kbwg, kbwg_node_p(node_at(kbwg, 0)), tileset, num_threads, &out);
+  if (!out_writer_free(&out)) goto errored;
+  stats_end_phase(Phase_Dump);
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
+  return !errored;
+}
+
+bool do_lang_rkbwg_gaddag(char **argv, Tile tileset[static 1], size_t num_threads) {
+  // assume argc >= 3.
+  bool errored = false;
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *kbwg = (const uint32_t *)file_content;
+  if (!report_kbwg_verify(kbwg, file_size, true)) goto errored;
+  stats_end_phase(Phase_Verify);
+  OutWriter out = out_writer_new(STDOUT_FILENO);
+  dump_kbwg_root(kbwg, kbwg_node_p(node_at(kbwg, 1)), tileset, num_threads, &out);
+  if (!out_writer_free(&out)) goto errored;
+  stats_end_phase(Phase_Dump);
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
+  return !errored;
+}
+
+// klv value formatter
+
+// 5^0 to 5^16. 5^16 << 24 still fits in 64 bits.
+static const uint64_t pow5_u64[17] = {
+  1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625,
+  48828125, 244140625, 1220703125, 6103515625, 30517578125, 152587890625,
+};
+
+static const uint64_t pow10_u64[17] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+  1000000000, 10000000000, 100000000000, 1000000000000, 10000000000000,
+  100000000000000, 1000000000000000, 10000000000000000,
+};
+
+// v = m * 2^e exactly. returns whether "%.<precision>f" of v reads back as v.
+// if v * 10^precision is an integer (which may not fit), sets *pexact and leaves *pr alone.
+// otherwise *pr = round_half_even(v * 10^precision), which is what printf prints.
+static inline bool klv_value_round_trips(uint32_t m, int32_t e, bool is_lower_boundary, uint32_t precision, uint64_t *pr, bool *pexact) {
+  int32_t k = -(e + (int32_t)precision);
+  *pexact = k <= 0;
+  if (*pexact) return true; // v * 10^precision is an integer.
+  uint64_t n = m * pow5_u64[precision]; // v * 10^precision = n / 2^k, n < 2^62.
+  uint64_t r, d; // d = |r * 2^k - n|, the error scaled by 2^k * 10^precision.
+  bool rounded_up = false;
+  if (k >= 63) {
+    r = 0;
+    d = n;
+  } else {
+    uint64_t rem = n & (((uint64_t)1 << k) - 1);
+    uint64_t half = (uint64_t)1 << (k - 1);
+    r = n >> k;
+    if (rem > half || (rem == half && (r & 1))) {
+      ++r;
+      d = ((uint64_t)1 << k) - rem;
+      rounded_up = true;
+    } else {
+      d = rem;
+    }
+  }
+  *pr = r;
+  // neighbors are 2^e away (2^(e-1) below a power of two), so the float reads back iff
+  // the error is within half of that. 5^precision is odd, so there are no ties.
+  return d <= pow5_u64[precision] >> (!rounded_up && is_lower_boundary ? 2 : 1);
+}
+
+// writes the same text as printf("%.*f", precision, val), where precision is what
+// bisecting 1 to 16 for the shortest "%.*f" that sscanf("%f") reads back as val finds.
+// buf must have at least 64 bytes. returns length written.
+size_t format_klv_value(char buf[static 64], float val) {
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  bool is_negative = bits >> 31;
+  uint32_t biased_exponent = (bits >> 23) & 0xff;
+  uint32_t m = bits & 0x7fffff;
+  if (biased_exponent == 0xff) return (size_t)snprintf(buf, 64, "%.1f", val); // inf or nan.
+  if (!biased_exponent && !m) return (size_t)snprintf(buf, 64, "%s0.0", is_negative ? "-" : "");
+  int32_t e = biased_exponent ? (int32_t)biased_exponent - 150 : -149;
+  if (biased_exponent) m |= 0x800000;
+  bool is_lower_boundary = biased_exponent > 1 && m == 0x800000;
+  // same bisection as the former snprintf+sscanf cascade.
+  uint32_t lo = 1, hi = 16;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) >> 1;
+    uint64_t r;
+    bool exact;
+    if (klv_value_round_trips(m, e, is_lower_boundary, mid, &r, &exact)) hi = mid; else lo = mid + 1;
+  }
+  uint64_t r = 0;
+  bool exact;
+  klv_value_round_trips(m, e, is_lower_boundary, lo, &r, &exact);
+  if (exact) return (size_t)snprintf(buf, 64, "%.*f", (int)lo, val); // large value, rare.
+  char *pbuf = buf;
+  if (is_negative) *pbuf++ = '-';
+  uint64_t int_part = r / pow10_u64[lo];
+  uint64_t frac_part = r % pow10_u64[lo];
+  char digits[24];
+  size_t num_digits = 0;
+  do {
+    digits[num_digits++] = (char)('0' + int_part % 10);
+    int_part /= 10;
+  } while (int_part);
+  while (num_digits) *pbuf++ = digits[--num_digits];
+  *pbuf++ = '.';
+  for (uint32_t i = lo; i-- > 0; ) {
+    pbuf[i] = (char)('0' + frac_part % 10);
+    frac_part /= 10;
+  }
+  pbuf += lo;
+  return (size_t)(pbuf - buf);
+}
+
+// klv2 values are consumed in dump order, so this is not split into jobs.
+void dump_klv2(const uint32_t *kwg, VecChar *word, uint32_t p, Tile tileset[static 1], const uint32_t **klv_ptr, OutWriter out[static 1]) {
+  if (!p) return;
+  VecDumpFrame stack = vecDumpFrame_new();
+  vecDumpFrame_push(&stack, &(DumpFrame){ .p = p, .word_len = word->len });
+  while (stack.len) {
+    DumpFrame *frame = &stack.ptr[stack.len - 1];
+    p = frame->p;
+    uint32_t node = node_at(kwg, p);
+    size_t len = word_put_label(word, frame->word_len, tileset[kwg_node_c(node)].label);
+    // advance before pushing, which may move the frame.
+    if (kwg_node_e(node)) --stack.len; else ++frame->p;
+    if (kwg_node_d(node)) {
+      uint32_t value_bits = node_at((*klv_ptr)++, 0);
+      float value;
+      memcpy(&value, &value_bits, sizeof(value));
+      vecChar_ensure_cap(word, len + 65);
+      word->ptr[len] = ',';
+      size_t s_len = format_klv_value(word->ptr + len + 1, value);
+      out_writer_write_line(out, word->ptr, len + 1 + s_len);
+    }
+    if (kwg_node_p(node)) vecDumpFrame_push(&stack, &(DumpFrame){ .p = kwg_node_p(node), .word_len = len });
+  }
+  vecDumpFrame_free(&stack);
 }
 
 bool do_lang_rklv2(char **argv, Tile tileset[static 1]) {
   // assume argc >= 3.
   bool errored = false;
-  bool defer_fclose = false;
-  bool defer_free_file_content = false;
+  bool defer_munmap = false;
   bool defer_free_word = false;
-  FILE *f = fopen(argv[2], "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
-  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
-  off_t file_size_signed = ftello(f); if (file_size_signed < 0) { perror("ftello"); goto errored; }
-  size_t file_size = (size_t)file_size_signed;
-  uint8_t *file_content = malloc_or_die(file_size); defer_free_file_content = true;
-  rewind(f);
-  if (fread(file_content, 1, file_size, f) != file_size) { perror("fread"); goto errored; }
-  if (is_big_endian()) swap_bytes_32(file_content, file_size);
-  uint32_t num_kwg_nodes = *(uint32_t *)file_content;
-  KwgNode *kwg = (KwgNode *)(file_content + sizeof(uint32_t));
-  float *klv_values = (float *)(file_content + sizeof(uint32_t) * (2 + num_kwg_nodes));
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  if (!report_klv2_verify((const uint32_t *)file_content, file_size)) goto errored;
+  stats_end_phase(Phase_Verify);
+  uint32_t num_kwg_nodes = node_at((const uint32_t *)file_content, 0);
+  const uint32_t *kwg = (const uint32_t *)file_content + 1;
+  const uint32_t *klv_values = (const uint32_t *)file_content + 2 + num_kwg_nodes;
   VecChar word = vecChar_new(); defer_free_word = true;
-  dump_klv2(kwg, &word, kwg[0].p, tileset, &klv_values);
+  OutWriter out = out_writer_new(STDOUT_FILENO);
+  dump_klv2(kwg, &word, kwg_node_p(node_at(kwg, 0)), tileset, &klv_values, &out);
+  if (!out_writer_free(&out)) goto errored;
+  stats_end_phase(Phase_Dump);
   goto cleanup;
 errored: errored = true;
 cleanup:
   if (defer_free_word) vecChar_free(&word);
-  if (defer_free_file_content) free(file_content);
-  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
+  return !errored;
+}
+
+// reads one rack per line from stdin, prints each with its value from the klv2 (or nothing after the comma if none).
+// is_dense reads a table from -klv-dense instead, where every rack up to the max length has a slot,
+// and racks that were not in the csv print nothing too.
+bool do_lang_lookup_klv2(char **argv, ParsedTile tileset_parse(uint8_t *), bool is_dense) {
+  // assume argc >= 3.
+  bool errored = false;
+  bool defer_munmap = false;
+  bool defer_free_lookup = false;
+  bool defer_free_line = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  Klv2Lookup lookup = { .counts = NULL }; // only set up if !is_dense.
+  KlvDense dense = { .values = NULL }; // only set up if is_dense.
+  if (is_dense) {
+    if (!report_klv_dense_verify((const uint32_t *)file_content, file_size)) goto errored;
+    klv_dense_init(&dense, (const uint32_t *)file_content);
+  } else {
+    if (!report_klv2_verify((const uint32_t *)file_content, file_size)) goto errored;
+    if (!klv2_lookup_init(&lookup, (const uint32_t *)file_content)) { fputs("out of memory\n", stderr); goto errored; } defer_free_lookup = true;
+  }
+  stats_end_phase(Phase_Verify);
+  char *line = NULL;
+  size_t line_cap = 0;
+  defer_free_line = true;
+  OutWriter out = out_writer_new(STDOUT_FILENO);
+  for (ssize_t line_len; (line_len = getline(&line, &line_cap, stdin)) >= 0; ) {
+    while (line_len > 0 && (uint8_t)line[line_len - 1] <= ' ') line[--line_len] = '\0';
+    uint8_t rack[KLV2_MAX_LEAVE_LEN];
+    size_t rack_len = 0;
+    for (size_t i = 0; i < (size_t)line_len; ) {
+      ParsedTile parsed_tile = tileset_parse((uint8_t *)line + i);
+      if (!parsed_tile.len || rack_len == KLV2_MAX_LEAVE_LEN) {
+        fprintf(stderr, "bad rack: %s\n", line);
+        out_writer_free(&out);
+        goto errored;
+      }
+      rack[rack_len++] = parsed_tile.index;
+      i += parsed_tile.len;
+    }
+    char buf[64];
+    size_t buf_len = 0;
+    if (is_dense) {
+      uint64_t index = klv_dense_index(&dense, rack, rack_len);
+      if (index != (uint64_t)-1) {
+        float value = klv_dense_value_at(&dense, index);
+        if (value == value) buf_len = format_klv_value(buf, value); // nan if not in the csv.
+      }
+    } else {
+      uint32_t index = klv2_leave_index(&lookup, rack, rack_len);
+      if (index != (uint32_t)-1) buf_len = format_klv_value(buf, klv2_value_at(&lookup, index));
+    }
+    out_writer_write(&out, line, (size_t)line_len);
+    out_writer_write(&out, ",", 1);
+    out_writer_write_line(&out, buf, buf_len);
+  }
+  if (!out_writer_free(&out)) goto errored;
+  stats_end_phase(Phase_Dump);
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_free_line) free(line);
+  if (defer_free_lookup) klv2_lookup_free(&lookup);
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
   return !errored;
 }
 
+// layout analysis
+
+// nodes are 4 bytes, files are mapped page-aligned.
+// a line is a --block of nodes (by default 16 nodes, a 64-byte cache line), set in layout_block_shift.
+#define LAYOUT_PAGE_SHIFT 10 // 1024 nodes per 4K page.
+#define LAYOUT_NUM_SAMPLES 10000
+#define LAYOUT_MAX_WORD_LEN 64
+#define LAYOUT_MAX_TOUCHED 256 // per lookup, more than any real lookup needs.
+
+// what one workload touched.
+typedef struct {
+  const uint32_t *nodes;
+  uint32_t num_nodes;
+  bool is_kbwg;
+  uint8_t *line_seen; // bitmaps over the whole file.
+  uint8_t *page_seen;
+  uint64_t distinct_lines;
+  uint64_t distinct_pages;
+  uint64_t nodes_visited;
+  uint64_t line_switches; // consecutive visits to different lines.
+  uint32_t last_line;
+  // per lookup.
+  uint32_t lookup_lines[LAYOUT_MAX_TOUCHED];
+  uint32_t lookup_pages[LAYOUT_MAX_TOUCHED];
+  size_t num_lookup_lines;
+  size_t num_lookup_pages;
+  uint64_t num_lookups;
+  uint64_t total_lookup_lines;
+  uint64_t total_lookup_pages;
+  size_t max_lookup_lines;
+  size_t max_lookup_pages;
+} LayoutTracker;
+
+static inline LayoutTracker layout_tracker_new(const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg) {
+  size_t num_lines = ((size_t)num_nodes >> layout_block_shift) + 1;
+  size_t num_pages = ((size_t)num_nodes >> LAYOUT_PAGE_SHIFT) + 1;
+  LayoutTracker ret = {
+    .nodes = nodes,
+    .num_nodes = num_nodes,
+    .is_kbwg = is_kbwg,
+    .line_seen = malloc_or_die((num_lines + 7) >> 3),
+    .page_seen = malloc_or_die((num_pages + 7) >> 3),
+    .last_line = (uint32_t)~0,
+  };
+  memset(ret.line_seen, 0, (num_lines + 7) >> 3);
+  memset(ret.page_seen, 0, (num_pages + 7) >> 3);
+  return ret;
+}
+
+static inline void layout_tracker_free(LayoutTracker self[static 1]) {
+  free(self->page_seen);
+  free(self->line_seen);
+}
+
+static inline void layout_add_distinct(uint32_t *set, size_t len[static 1], uint32_t x) {
+  for (size_t i = *len; i-- > 0; ) if (set[i] == x) return;
+  if (*len < LAYOUT_MAX_TOUCHED) set[(*len)++] = x;
+}
+
+static inline uint32_t layout_touch(LayoutTracker self[static 1], uint32_t i) {
+  uint32_t line = i >> layout_block_shift;
+  uint32_t page = i >> LAYOUT_PAGE_SHIFT;
+  ++self->nodes_visited;
+  if (line != self->last_line) { ++self->line_switches; self->last_line = line; }
+  if (!(self->line_seen[line >> 3] & (1 << (line & 7)))) { self->line_seen[line >> 3] |= (uint8_t)(1 << (line & 7)); ++self->distinct_lines; }
+  if (!(self->page_seen[page >> 3] & (1 << (page & 7)))) { self->page_seen[page >> 3] |= (uint8_t)(1 << (page & 7)); ++self->distinct_pages; }
+  layout_add_distinct(self->lookup_lines, &self->num_lookup_lines, line);
+  layout_add_distinct(self->lookup_pages, &self->num_lookup_pages, page);
+  return node_at(self->nodes, i);
+}
+
+static inline void layout_end_lookup(LayoutTracker self[static 1]) {
+  ++self->num_lookups;
+  self->total_lookup_lines += self->num_lookup_lines;
+  self->total_lookup_pages += self->num_lookup_pages;
+  if (self->num_lookup_lines > self->max_lookup_lines) self->max_lookup_lines = self->num_lookup_lines;
+  if (self->num_lookup_pages > self->max_lookup_pages) self->max_lookup_pages = self->num_lookup_pages;
+  self->num_lookup_lines = 0;
+  self->num_lookup_pages = 0;
+}
+
+// looks up like a real lookup, returns the matching node's index or 0.
+// touches what a node by node scan of the sibling list at p would.
+static inline uint32_t layout_seek(LayoutTracker self[static 1], uint32_t p, uint8_t c) {
+  uint32_t q = self->is_kbwg ? kbwg_seek(self->nodes, self->num_nodes, p, c) : kwg_seek(self->nodes, self->num_nodes, p, c);
+  if (q) {
+    for (; p <= q; ++p) layout_touch(self, p);
+  } else if (p) {
+    while (!layout_node_e(layout_touch(self, p), self->is_kbwg)) ++p;
+  }
+  return q;
+}
+
+static void fprint_layout_tracker(FILE *fp, const char name[static 1], LayoutTracker self[static 1]) {
+  fprintf(fp, "%s: %" PRIu64 " nodes visited, %" PRIu64 " line switches (%.3f per node)\n",
+    name, self->nodes_visited, self->line_switches, self->nodes_visited ? (double)self->line_switches / (double)self->nodes_visited : 0.0);
+  if (self->num_lookups) {
+    fprintf(fp, "  %" PRIu64 " lookups, lines per lookup %.3f (max %zu), pages per lookup %.3f (max %zu)\n",
+      self->num_lookups, (double)self->total_lookup_lines / (double)self->num_lookups, self->max_lookup_lines,
+      (double)self->total_lookup_pages / (double)self->num_lookups, self->max_lookup_pages);
+  }
+  fprintf(fp, "  working set %" PRIu64 " lines (%" PRIu64 " KiB), %" PRIu64 " pages (%" PRIu64 " KiB)\n",
+    self->distinct_lines, (self->distinct_lines << (layout_block_shift + 2)) / 1024, self->distinct_pages, self->distinct_pages * 4);
+}
+
+typedef struct {
+  uint8_t tiles[LAYOUT_MAX_WORD_LEN];
+  uint8_t len;
+} LayoutSample;
+
+typedef struct {
+  uint32_t p;
+  uint32_t word_len;
+} LayoutFrame;
+
+#define VEC_ELT_NAME LayoutFrame
+#define VEC_ELT_T LayoutFrame
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+// walks every word in the dawg, keeping a fixed-seed reservoir sample of them.
+static uint64_t layout_full_traversal(LayoutTracker tracker[static 1], uint32_t p, LayoutSample *samples, size_t num_samples[static 1]) {
+  uint64_t num_words = 0;
+  uint64_t rng = 1;
+  uint8_t tiles[LAYOUT_MAX_WORD_LEN];
+  VecLayoutFrame stack = vecLayoutFrame_new();
+  if (p) vecLayoutFrame_push(&stack, &(LayoutFrame){ .p = p, .word_len = 0 });
+  while (stack.len) {
+    LayoutFrame *frame = &stack.ptr[stack.len - 1];
+    uint32_t node = layout_touch(tracker, frame->p);
+    uint32_t word_len = frame->word_len;
+    if (layout_node_e(node, tracker->is_kbwg)) --stack.len; else ++frame->p;
+    if (word_len < LAYOUT_MAX_WORD_LEN) tiles[word_len] = layout_node_c(node, tracker->is_kbwg);
+    if (layout_node_d(node, tracker->is_kbwg) && word_len < LAYOUT_MAX_WORD_LEN) {
+      uint64_t slot = num_words < LAYOUT_NUM_SAMPLES ? num_words : rng_next(&rng) % (num_words + 1);
+      if (slot < LAYOUT_NUM_SAMPLES) {
+        memcpy(samples[slot].tiles, tiles, word_len + 1);
+        samples[slot].len = (uint8_t)(word_len + 1);
+      }
+      ++num_words;
+    }
+    uint32_t child = layout_node_p(node, tracker->is_kbwg);
+    if (child) vecLayoutFrame_push(&stack, &(LayoutFrame){ .p = child, .word_len = word_len + 1 });
+  }
+  vecLayoutFrame_free(&stack);
+  *num_samples = num_words < LAYOUT_NUM_SAMPLES ? (size_t)num_words : LAYOUT_NUM_SAMPLES;
+  layout_end_lookup(tracker); // the whole traversal is one lookup, not reported.
+  tracker->num_lookups = 0;
+  return num_words;
+}
+
+// is_kbwg selects the node format, has_gaddag also does the anchor walks.
+void analyze_layout(FILE *fp, const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg, bool has_gaddag) {
+  fprintf(fp, "file: %u nodes, %u lines, %u pages\n", num_nodes,
+    ((num_nodes - 1) >> layout_block_shift) + 1, ((num_nodes - 1) >> LAYOUT_PAGE_SHIFT) + 1);
+
+  // sibling lists, found through the arcs pointing at them.
+  uint8_t *is_head = malloc_or_die(num_nodes);
+  memset(is_head, 0, num_nodes);
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    uint32_t p = layout_node_p(node_at(nodes, i), is_kbwg);
+    if (p < num_nodes) is_head[p] = 1;
+  }
+  is_head[0] = 0;
+  uint64_t num_lists = 0, num_list_nodes = 0, line_straddles = 0, avoidable_line_straddles = 0, page_straddles = 0;
+  uint32_t max_list_len = 0;
+  for (uint32_t h = 1; h < num_nodes; ++h) {
+    if (!is_head[h]) continue;
+    uint32_t end = h;
+    while (end + 1 < num_nodes && !layout_node_e(node_at(nodes, end), is_kbwg)) ++end;
+    uint32_t len = end - h + 1;
+    ++num_lists;
+    num_list_nodes += len;
+    if (len > max_list_len) max_list_len = len;
+    if ((h >> layout_block_shift) != (end >> layout_block_shift)) {
+      ++line_straddles;
+      avoidable_line_straddles += len <= ((uint32_t)1 << layout_block_shift);
+    }
+    page_straddles += (h >> LAYOUT_PAGE_SHIFT) != (end >> LAYOUT_PAGE_SHIFT);
+  }
+  free(is_head);
+  fprintf(fp, "sibling lists: %" PRIu64 " (mean length %.3f, max %u)\n",
+    num_lists, num_lists ? (double)num_list_nodes / (double)num_lists : 0.0, max_list_len);
+  fprintf(fp, "  straddling a line: %" PRIu64 " (%.3f%%), of which short enough to fit one: %" PRIu64 "\n",
+    line_straddles, num_lists ? 100.0 * (double)line_straddles / (double)num_lists : 0.0, avoidable_line_straddles);
+  fprintf(fp, "  straddling a page: %" PRIu64 " (%.3f%%)\n",
+    page_straddles, num_lists ? 100.0 * (double)page_straddles / (double)num_lists : 0.0);
+
+  LayoutSample *samples = malloc_or_die(LAYOUT_NUM_SAMPLES * sizeof(LayoutSample));
+  size_t num_samples = 0;
+  uint32_t dawg_p = layout_node_p(node_at(nodes, 0), is_kbwg);
+  {
+    LayoutTracker tracker = layout_tracker_new(nodes, num_nodes, is_kbwg);
+    uint64_t num_words = layout_full_traversal(&tracker, dawg_p, samples, &num_samples);
+    fprintf(fp, "full traversal (%" PRIu64 " words)", num_words);
+    fprint_layout_tracker(fp, "", &tracker);
+    layout_tracker_free(&tracker);
+  }
+  {
+    LayoutTracker tracker = layout_tracker_new(nodes, num_nodes, is_kbwg);
+    for (size_t i = 0; i < num_samples; ++i) {
+      uint32_t p = dawg_p;
+      for (uint8_t j = 0; j < samples[i].len && p; ++j) {
+        p = layout_seek(&tracker, p, samples[i].tiles[j]);
+        if (p && j + 1 < samples[i].len) p = layout_node_p(node_at(nodes, p), is_kbwg);
+      }
+      layout_end_lookup(&tracker);
+    }
+    fprintf(fp, "word lookups (%zu random words)", num_samples);
+    fprint_layout_tracker(fp, "", &tracker);
+    layout_tracker_free(&tracker);
+  }
+  if (has_gaddag) {
+    // CARE has anchors ERAC, RAC@E, AC@RE, C@ARE.
+    LayoutTracker tracker = layout_tracker_new(nodes, num_nodes, is_kbwg);
+    uint32_t gaddag_p = layout_node_p(node_at(nodes, 1), is_kbwg);
+    for (size_t i = 0; i < num_samples; ++i) {
+      LayoutSample *sample = &samples[i];
+      for (uint8_t anchor = 0; anchor < sample->len; ++anchor) {
+        uint8_t path[LAYOUT_MAX_WORD_LEN + 1];
+        uint8_t path_len = 0;
+        for (uint8_t j = anchor + 1; j-- > 0; ) path[path_len++] = sample->tiles[j];
+        if (anchor + 1 < sample->len) {
+          path[path_len++] = 0;
+          for (uint8_t j = anchor + 1; j < sample->len; ++j) path[path_len++] = sample->tiles[j];
+        }
+        uint32_t p = gaddag_p;
+        for (uint8_t j = 0; j < path_len && p; ++j) {
+          p = layout_seek(&tracker, p, path[j]);
+          if (p && j + 1 < path_len) p = layout_node_p(node_at(nodes, p), is_kbwg);
+        }
+        layout_end_lookup(&tracker);
+      }
+    }
+    fprintf(fp, "gaddag anchor walks");
+    fprint_layout_tracker(fp, "", &tracker);
+    layout_tracker_free(&tracker);
+  }
+  free(samples);
+}
+
+bool do_lang_analyze_layout(char **argv, int mode) {
+  // assume argc >= 3. mode in [0 (kwg dawgonly), 1 (kwg gaddawg), 2 (kbwg gaddawg)].
+  bool errored = false;
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *nodes = (const uint32_t *)file_content;
+  bool ok = mode == 2 ? report_kbwg_verify(nodes, file_size, true) : report_kwg_verify(nodes, file_size, mode == 1);
+  if (!ok) goto errored;
+  stats_end_phase(Phase_Verify);
+  analyze_layout(stdout, nodes, (uint32_t)(file_size / sizeof(uint32_t)), mode == 2, mode != 0);
+  stats_end_phase(Phase_Analyze);
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
+  return !errored;
+}
+
+// structure stats
+
+#define STATS_MAX_DEPTH 32 // deeper nodes are counted in the last bucket.
+#define STATS_MAX_LIST_LEN 64 // longer lists are counted in the last bucket.
+
+// breadth first over sibling lists from p, so each node gets its shallowest depth.
+// sets reach_bit in reach for every node reached, marks list heads in is_head.
+static void walk_lists_by_depth(const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg, uint32_t p, uint8_t reach_bit, uint8_t *reach, uint8_t *is_head, uint64_t depths[static STATS_MAX_DEPTH + 1]) {
+  if (!p) return;
+  uint8_t *queued = malloc_or_die(num_nodes);
+  memset(queued, 0, num_nodes);
+  uint32_t *queue = malloc_or_die((size_t)num_nodes * sizeof(uint32_t));
+  size_t queue_head = 0, queue_len = 0, level_end = 1;
+  uint32_t depth = 1;
+  queue[queue_len++] = p;
+  queued[p] = 1;
+  for (; queue_head < queue_len; ++queue_head) {
+    if (queue_head == level_end) { ++depth; level_end = queue_len; }
+    is_head[queue[queue_head]] = 1;
+    for (uint32_t i = queue[queue_head]; ; ++i) {
+      uint32_t node = node_at(nodes, i);
+      if (!(reach[i] & reach_bit)) {
+        reach[i] |= reach_bit;
+        ++depths[depth < STATS_MAX_DEPTH ? depth : STATS_MAX_DEPTH];
+      }
+      uint32_t child = layout_node_p(node, is_kbwg);
+      if (child && !queued[child]) { queued[child] = 1; queue[queue_len++] = child; }
+      if (layout_node_e(node, is_kbwg)) break;
+    }
+  }
+  free(queue);
+  free(queued);
+}
+
+static void fprint_histogram(FILE *fp, const char name[static 1], const uint64_t *counts, size_t len) {
+  size_t last = len;
+  while (last > 0 && !counts[last - 1]) --last;
+  fprintf(fp, "%s:", name);
+  for (size_t i = 1; i < last; ++i) fprintf(fp, " %zu%s:%" PRIu64, i, i + 1 == len ? "+" : "", counts[i]);
+  fprintf(fp, "\n");
+}
+
+// has_gaddag means node 1 is the gaddag root. max_nodes is what the format can address.
+bool print_structure_stats(FILE *fp, const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg, bool has_gaddag, uint32_t max_nodes) {
+  bool ok = false;
+  uint32_t num_roots = has_gaddag ? 2 : 1;
+  uint32_t dawg_p = layout_node_p(node_at(nodes, 0), is_kbwg);
+  uint32_t gaddag_p = has_gaddag ? layout_node_p(node_at(nodes, 1), is_kbwg) : 0;
+  uint64_t *words = malloc_or_die((size_t)num_nodes * sizeof(uint64_t));
+  uint64_t *tries = malloc_or_die((size_t)num_nodes * sizeof(uint64_t));
+  uint8_t *states = malloc_or_die(num_nodes);
+  uint8_t *reach = malloc_or_die(num_nodes); // 1 = from dawg, 2 = from gaddag.
+  uint8_t *is_head = malloc_or_die(num_nodes);
+  memset(states, 0, num_nodes);
+  memset(reach, 0, num_nodes);
+  memset(is_head, 0, num_nodes);
+  if (!nodes_count_list_words(nodes, num_nodes, is_kbwg, dawg_p, words, tries, states) ||
+    !nodes_count_list_words(nodes, num_nodes, is_kbwg, gaddag_p, words, tries, states)) {
+    fputs("arcs form a cycle (or out of memory)\n", stderr);
+    goto cleanup;
+  }
+  uint64_t dawg_depths[STATS_MAX_DEPTH + 1] = { 0 };
+  uint64_t gaddag_depths[STATS_MAX_DEPTH + 1] = { 0 };
+  walk_lists_by_depth(nodes, num_nodes, is_kbwg, dawg_p, 1, reach, is_head, dawg_depths);
+  walk_lists_by_depth(nodes, num_nodes, is_kbwg, gaddag_p, 2, reach, is_head, gaddag_depths);
+
+  uint64_t by_reach[4] = { 0 }, num_gaps = 0;
+  for (uint32_t i = num_roots; i < num_nodes; ++i) {
+    // all-zero nodes are gaps left by the block packing, not lost lists.
+    if (!reach[i] && !node_at(nodes, i)) ++num_gaps; else ++by_reach[reach[i]];
+  }
+  uint64_t num_reachable = by_reach[1] + by_reach[2] + by_reach[3];
+  uint64_t num_lists = 0, num_list_nodes = 0, list_lens[STATS_MAX_LIST_LEN + 1] = { 0 };
+  uint32_t max_fanout = 0;
+  for (uint32_t h = num_roots; h < num_nodes; ++h) {
+    if (!is_head[h]) continue;
+    uint32_t len = 1;
+    while (!layout_node_e(node_at(nodes, h + len - 1), is_kbwg)) ++len;
+    ++num_lists;
+    num_list_nodes += len;
+    ++list_lens[len < STATS_MAX_LIST_LEN ? len : STATS_MAX_LIST_LEN];
+    if (len > max_fanout) max_fanout = len;
+  }
+  uint64_t num_trie_nodes = (dawg_p ? tries[dawg_p] : 0) + (gaddag_p ? tries[gaddag_p] : 0);
+
+  fprintf(fp, "nodes: %u (%u roots, %" PRIu64 " reachable, %" PRIu64 " gaps, %" PRIu64 " unreachable)\n",
+    num_nodes, num_roots, num_reachable, num_gaps, by_reach[0]);
+  if (has_gaddag) {
+    fprintf(fp, "  dawg only %" PRIu64 ", gaddag only %" PRIu64 ", shared %" PRIu64 "\n", by_reach[1], by_reach[2], by_reach[3]);
+  }
+  fprintf(fp, "words: %" PRIu64 "\n", dawg_p ? words[dawg_p] : 0);
+  if (has_gaddag) fprintf(fp, "gaddag paths: %" PRIu64 "\n", gaddag_p ? words[gaddag_p] : 0);
+  fprintf(fp, "sharing: %" PRIu64 " trie nodes in %" PRIu64 " nodes (ratio %.3f)\n",
+    num_trie_nodes, num_reachable, num_reachable ? (double)num_trie_nodes / (double)num_reachable : 0.0);
+  fprintf(fp, "sibling lists: %" PRIu64 " (mean length %.3f, max fanout %u)\n",
+    num_lists, num_lists ? (double)num_list_nodes / (double)num_lists : 0.0, max_fanout);
+  fprint_histogram(fp, "  lengths", list_lens, STATS_MAX_LIST_LEN + 1);
+  fprint_histogram(fp, "dawg depths", dawg_depths, STATS_MAX_DEPTH + 1);
+  if (has_gaddag) fprint_histogram(fp, "gaddag depths", gaddag_depths, STATS_MAX_DEPTH + 1);
+  fprintf(fp, "headroom: %u of %u nodes used (%.3f%%), %u left\n",
+    num_nodes, max_nodes, 100.0 * (double)num_nodes / (double)max_nodes, max_nodes - num_nodes);
+  ok = true;
+cleanup:
+  free(is_head);
+  free(reach);
+  free(states);
+  free(tries);
+  free(words);
+  return ok;
+}
+
+bool do_lang_structure_stats(char **argv, int mode) {
+  // assume argc >= 3. mode in [0 (kwg dawgonly), 1 (kwg gaddawg), 2 (kbwg gaddawg), 3 (klv2)].
+  bool errored = false;
+  bool defer_munmap = false;
+  size_t file_size;
+  uint8_t *file_content = mmap_file_or_null(argv[2], &file_size); if (!file_content) goto errored; defer_munmap = true;
+  stats_end_phase(Phase_Read);
+  const uint32_t *nodes = (const uint32_t *)file_content;
+  bool ok = mode == 3 ? report_klv2_verify(nodes, file_size) :
+    mode == 2 ? report_kbwg_verify(nodes, file_size, true) :
+    report_kwg_verify(nodes, file_size, mode == 1);
+  if (!ok) goto errored;
+  stats_end_phase(Phase_Verify);
+  uint32_t num_nodes = (uint32_t)(file_size / sizeof(uint32_t));
+  if (mode == 3) {
+    // the kwg inside, then the values.
+    num_nodes = node_at(nodes, 0);
+    printf("values: %u\n", node_at(nodes, 1 + num_nodes));
+    ++nodes;
+  }
+  ok = print_structure_stats(stdout, nodes, num_nodes, mode == 2, mode == 1 || mode == 2, mode == 2 ? 0x1000000 : 0x400000);
+  stats_end_phase(Phase_Analyze);
+  if (!ok) goto errored;
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  if (defer_munmap) { if (munmap(file_content, file_size)) { perror("munmap"); errored = true; } }
+  return !errored;
+}
+
+// parses the optional "-j N" after the input file.
+bool parse_num_threads(int argc, char **argv, size_t num_threads[static 1]) {
+  *num_threads = 1;
+  if (argc < 4) return true;
+  char check; // check if the int is followed by some junk after whitespace.
+  if (argc == 5 && !strcmp(argv[3], "-j") && sscanf(argv[4], "%zu %c", num_threads, &check) == 1 && *num_threads > 0) return true;
+  fprintf(stderr, "%s: expected -j N after the input file\n", argv[1]);
+  return false;
+}
+
 bool do_lang(int argc, char **argv, const char lang_name[static 1], ParsedTile tileset_parse(uint8_t *), Tile tileset[static 1]) {
   size_t lang_name_len = strlen(lang_name);
   if (!(argc > 1 && !strncmp(argv[1], lang_name, lang_name_len))) {
@@ -1486,45 +3419,119 @@ bool do_lang(int argc, char **argv, const char lang_name[static 1], ParsedTile t
   } else if (!strncmp(argv[1] + lang_name_len, "-experimental", strlen("-experimental"))) {
     lang_name_len += strlen("-experimental");
     build_layout = BuildLayout_Experimental;
+  } else if (!strncmp(argv[1] + lang_name_len, "-hot", strlen("-hot"))) {
+    lang_name_len += strlen("-hot");
+    build_layout = BuildLayout_Hot;
+  } else if (!strncmp(argv[1] + lang_name_len, "-paged", strlen("-paged"))) {
+    lang_name_len += strlen("-paged");
+    build_layout = BuildLayout_Paged;
+  } else if (!strncmp(argv[1] + lang_name_len, "-profiled", strlen("-profiled"))) {
+    lang_name_len += strlen("-profiled");
+    build_layout = BuildLayout_Profiled;
   } else {
     build_layout = BuildLayout_Wolges;
   }
+  // the profiled layout also needs the profile after the output file.
+  int build_argc = build_layout == BuildLayout_Profiled ? 5 : 4;
   if (false) {
   } else if (!strcmp(argv[1] + lang_name_len, "-klv2")) {
-    if (argc < 4) goto needs_more_args;
+    if (argc < build_argc) goto needs_more_args;
     return do_lang_klv2(argv, tileset_parse, build_layout);
-  } else if (!strcmp(argv[1] + lang_name_len, "-kwg")) {
+  } else if (!strcmp(argv[1] + lang_name_len, "-klv-dense")) {
     if (argc < 4) goto needs_more_args;
+    return do_lang_klv_dense(argv, tileset_parse);
+  } else if (!strcmp(argv[1] + lang_name_len, "-kwg")) {
+    if (argc < build_argc) goto needs_more_args;
     return do_lang_kwg(argv, tileset_parse, build_layout, 1);
   } else if (!strcmp(argv[1] + lang_name_len, "-kbwg")) {
-    if (argc < 4) goto needs_more_args;
+    if (argc < build_argc) goto needs_more_args;
     return do_lang_kbwg(argv, tileset_parse, build_layout, 1);
   } else if (!strcmp(argv[1] + lang_name_len, "-kwg-alpha")) {
-    if (argc < 4) goto needs_more_args;
+    if (argc < build_argc) goto needs_more_args;
     return do_lang_kwg(argv, tileset_parse, build_layout, 2);
   } else if (!strcmp(argv[1] + lang_name_len, "-kwg-dawg")) {
-    if (argc < 4) goto needs_more_args;
+    if (argc < build_argc) goto needs_more_args;
     return do_lang_kwg(argv, tileset_parse, build_layout, 0);
   } else if (!strcmp(argv[1] + lang_name_len, "-read-kwg")) {
     if (argc < 3) goto needs_more_args;
     time_goes_to_stderr = true;
-    return do_lang_rkwg(argv, tileset);
+    size_t num_threads;
+    if (!parse_num_threads(argc, argv, &num_threads)) return true;
+    return do_lang_rkwg(argv, tileset, num_threads);
   } else if (!strcmp(argv[1] + lang_name_len, "-read-kwg-gaddag")) {
     if (argc < 3) goto needs_more_args;
     time_goes_to_stderr = true;
-    return do_lang_rkwg_gaddag(argv, tileset);
+    size_t num_threads;
+    if (!parse_num_threads(argc, argv, &num_threads)) return true;
+    return do_lang_rkwg_gaddag(argv, tileset, num_threads);
   } else if (!strcmp(argv[1] + lang_name_len, "-read-kbwg")) {
     if (argc < 3) goto needs_more_args;
     time_goes_to_stderr = true;
-    return do_lang_rkbwg(argv, tileset);
+    size_t num_threads;
+    if (!parse_num_threads(argc, argv, &num_threads)) return true;
+    return do_lang_rkbwg(argv, tileset, num_threads);
   } else if (!strcmp(argv[1] + lang_name_len, "-read-kbwg-gaddag")) {
     if (argc < 3) goto needs_more_args;
     time_goes_to_stderr = true;
-    return do_lang_rkbwg_gaddag(argv, tileset);
+    size_t num_threads;
+    if (!parse_num_threads(argc, argv, &num_threads)) return true;
+    return do_lang_rkbwg_gaddag(argv, tileset, num_threads);
+  } else if (!strcmp(argv[1] + lang_name_len, "-verify-kwg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_verify(argv, 1);
+  } else if (!strcmp(argv[1] + lang_name_len, "-verify-kwg-dawg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_verify(argv, 0);
+  } else if (!strcmp(argv[1] + lang_name_len, "-verify-kbwg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_verify(argv, 2);
+  } else if (!strcmp(argv[1] + lang_name_len, "-verify-klv2")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_verify(argv, 3);
+  } else if (!strcmp(argv[1] + lang_name_len, "-analyze-layout")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_analyze_layout(argv, 1);
+  } else if (!strcmp(argv[1] + lang_name_len, "-analyze-layout-dawg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_analyze_layout(argv, 0);
+  } else if (!strcmp(argv[1] + lang_name_len, "-analyze-layout-kbwg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_analyze_layout(argv, 2);
+  } else if (!strcmp(argv[1] + lang_name_len, "-stats")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_structure_stats(argv, 1);
+  } else if (!strcmp(argv[1] + lang_name_len, "-stats-dawg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_structure_stats(argv, 0);
+  } else if (!strcmp(argv[1] + lang_name_len, "-stats-kbwg")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_structure_stats(argv, 2);
+  } else if (!strcmp(argv[1] + lang_name_len, "-stats-klv2")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_structure_stats(argv, 3);
   } else if (!strcmp(argv[1] + lang_name_len, "-read-klv2")) {
     if (argc < 3) goto needs_more_args;
     time_goes_to_stderr = true;
     return do_lang_rklv2(argv, tileset);
+  } else if (!strcmp(argv[1] + lang_name_len, "-lookup-klv2")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_lookup_klv2(argv, tileset_parse, false);
+  } else if (!strcmp(argv[1] + lang_name_len, "-lookup-klv-dense")) {
+    if (argc < 3) goto needs_more_args;
+    time_goes_to_stderr = true;
+    return do_lang_lookup_klv2(argv, tileset_parse, true);
   } else {
     return false;
   }
@@ -1536,6 +3543,78 @@ needs_more_args:
 
 int main(int argc, char **argv) {
   struct timeval tv_start = now();
+  stats_phase_start_ns = now_ns();
+  uint64_t start_ns = stats_phase_start_ns;
+  // strip --stats, --stats=text, --stats=json, --perf, layout and sidecar options from anywhere in argv.
+  {
+    int new_argc = 0;
+    bool wants_perf = false;
+    uint32_t block_nodes = 16, align_nodes = 32;
+    for (int i = 0; i < argc; ++i) {
+      char check; // check if the int is followed by some junk.
+      if (i > 0 && !strcmp(argv[i], "--perf")) {
+        wants_perf = true;
+      } else if (i > 0 && !strncmp(argv[i], "--block=", strlen("--block="))) {
+        if (sscanf(argv[i] + strlen("--block="), "%u%c", &block_nodes, &check) != 1 ||
+            (block_nodes != 8 && block_nodes != 16 && block_nodes != 32)) {
+          fprintf(stderr, "%s: expected 8, 16 or 32\n", argv[i]);
+          return 1;
+        }
+      } else if (i > 0 && !strncmp(argv[i], "--align=", strlen("--align="))) {
+        if (sscanf(argv[i] + strlen("--align="), "%u%c", &align_nodes, &check) != 1 ||
+            !align_nodes || (align_nodes & (align_nodes - 1)) || align_nodes > 1024) {
+          fprintf(stderr, "%s: expected a power of 2 up to 1024\n", argv[i]);
+          return 1;
+        }
+      } else if (i > 0 && !strncmp(argv[i], "--hot-depth=", strlen("--hot-depth="))) {
+        if (sscanf(argv[i] + strlen("--hot-depth="), "%u%c", &layout_hot_depth, &check) != 1) {
+          fprintf(stderr, "%s: expected a number\n", argv[i]);
+          return 1;
+        }
+      } else if (i > 0 && !strncmp(argv[i], "--hot-top=", strlen("--hot-top="))) {
+        if (sscanf(argv[i] + strlen("--hot-top="), "%u%c", &layout_hot_top, &check) != 1) {
+          fprintf(stderr, "%s: expected a number\n", argv[i]);
+          return 1;
+        }
+      } else if (i > 0 && !strncmp(argv[i], "--jump=", strlen("--jump="))) {
+        if (sscanf(argv[i] + strlen("--jump="), "%u%c", &sidecar_jump_depth, &check) != 1 ||
+            !sidecar_jump_depth || sidecar_jump_depth > SIDECAR_MAX_JUMP_DEPTH) {
+          fprintf(stderr, "%s: expected 1 to %d\n", argv[i], SIDECAR_MAX_JUMP_DEPTH);
+          return 1;
+        }
+      } else if (i > 0 && !strcmp(argv[i], "--child-masks")) {
+        sidecar_child_masks = true;
+      } else if (i > 0 && !strcmp(argv[i], "--hooks")) {
+        sidecar_hooks = true;
+      } else if (i > 0 && !strcmp(argv[i], "--lengths")) {
+        sidecar_lengths = true;
+      } else if (i > 0 && !strcmp(argv[i], "--counts")) {
+        sidecar_counts = true;
+      } else if (i > 0 && (!strcmp(argv[i], "--stats") || !strcmp(argv[i], "--stats=text"))) {
+        stats_format = StatsFormat_Text;
+      } else if (i > 0 && !strcmp(argv[i], "--stats=json")) {
+        stats_format = StatsFormat_Json;
+      } else {
+        argv[new_argc++] = argv[i];
+      }
+    }
+    argv[new_argc] = NULL;
+    argc = new_argc;
+    if (align_nodes < block_nodes) {
+      fprintf(stderr, "--align=%u: expected at least --block=%u\n", align_nodes, block_nodes);
+      return 1;
+    }
+    layout_block_shift = (uint8_t)__builtin_ctz(block_nodes);
+    layout_align_shift = (uint8_t)__builtin_ctz(align_nodes);
+    if (wants_perf) {
+      // --perf implies --stats.
+      if (stats_format == StatsFormat_None) stats_format = StatsFormat_Text;
+      perf_open();
+      perf_end_phase(Phase_Read); // only to set perf.group.last.
+      memset(perf.phase_counts, 0, sizeof(perf.phase_counts));
+      stats_phase_start_ns = now_ns();
+    }
+  }
   if (
     do_lang(argc, argv, "english", english_tileset_parse, english_tileset) ||
     do_lang(argc, argv, "catalan", catalan_tileset_parse, catalan_tileset) ||
@@ -1551,15 +3630,24 @@ int main(int argc, char **argv) {
     false // so newer tilesets can be added without git diff
   ) {
     struct timeval tv_end = now();
+    uint64_t end_ns = now_ns();
     FILE *time_stream = time_goes_to_stderr ? stderr : stdout;
-    fputs("time taken: ", time_stream);
-    fprint_dur_us(time_stream, tv_end, tv_start);
-    fputs("s\n", time_stream);
+    if (stats_format != StatsFormat_Json) {
+      fputs("time taken: ", time_stream);
+      fprint_dur_us(time_stream, tv_end, tv_start);
+      fputs("s\n", time_stream);
+    }
+    if (stats_format != StatsFormat_None) fprint_stats(time_stream, end_ns - start_ns);
+    if (perf.enabled) perf_close();
   } else {
     puts(
       "args:\n"
       "  english-klv2 english.csv english.klv2\n"
       "    generate klv2 file. the csv support is incomplete, no quoting allowed.\n"
+      "  english-klv-dense english.csv english.kld\n"
+      "    generate a flat table with a value for every rack up to the longest leave\n"
+      "    (racks not in the csv are stored as nan, and looked up as missing)\n"
+      "    (for up to 16 tiles, the layout options do not apply)\n"
       "  english-kwg CSW21.txt CSW21.kwg\n"
       "    generate kwg file containing gaddawg (supports 4M nodes)\n"
       "  english-kbwg CSW24.txt CSW24.kbwg\n"
@@ -1572,17 +3660,50 @@ int main(int argc, char **argv) {
       "    english-magpiemerged-... for magpie ordering with wolges merging,\n"
       "    english-experimental-... for experimental,\n"
       "    english-legacy-... for legacy (which is the former default),\n"
+      "    english-hot-... for the default with sibling lists within --hot-depth=2 of\n"
+      "      a root (and the --hot-top=0 most reached ones) packed first,\n"
+      "    english-paged-... for subtrees clustered into 4K pages, then packed into blocks,\n"
+      "    english-profiled-... for the default with the most looked up sibling lists\n"
+      "      packed first, which takes a profile after the output file, with lines\n"
+      "      like WORD,123 (or leave,123 for klv2) or one WORD per lookup,\n"
       "    this is applicable for kwg, kwg-anything, klv/klv2)\n"
+      "  (experimental, default, paged, profiled and hot layouts pack sibling lists into blocks of\n"
+      "    --block=16 nodes (or 8 or 32), and start longer lists at multiples of\n"
+      "    --align=32 nodes (any power of 2 from the block size up to 1024))\n"
+      "  (kwg, kwg-dawg, kwg-alpha and kbwg can also take --jump=2 to also write\n"
+      "    outfile.jump, mapping every prefix of up to 2 tiles to its node,\n"
+      "    --child-masks to also write outfile.cmask, the tiles in each sibling list,\n"
+      "    --hooks to also write outfile.hooks, the same plus the tiles that accept,\n"
+      "    --lengths to also write outfile.lens, how far below each node words end,\n"
+      "    and --counts to also write outfile.counts, for numbering words in dump order)\n"
       "  english-read-kwg infile.kwg\n"
-      "    read kwg on a little-endian system (dawg part only)\n"
+      "    read kwg (dawg part only)\n"
       "  english-read-kbwg infile.kbwg\n"
-      "    read kbwg on a little-endian system (dawg part only)\n"
+      "    read kbwg (dawg part only)\n"
       "  english-read-kwg-gaddag infile.kwg\n"
-      "    read gaddag part of kwg on a little-endian system\n"
+      "    read gaddag part of kwg\n"
       "  english-read-kbwg-gaddag infile.kbwg\n"
-      "    read gaddag part of kbwg on a little-endian system\n"
+      "    read gaddag part of kbwg\n"
       "  english-read-klv2 infile.klv2\n"
-      "    read klv2 on a little-endian system\n"
+      "    read klv2\n"
+      "  english-lookup-klv2 infile.klv2 < racks.txt\n"
+      "    print the value of each rack (one per line, any order, ? for blank)\n"
+      "    (also -lookup-klv-dense infile.kld)\n"
+      "  english-verify-kwg infile.kwg\n"
+      "    check that a gaddawg kwg is structurally sound (also -verify-kwg-dawg\n"
+      "    for dawg-only kwg or kad, -verify-kbwg, -verify-klv2)\n"
+      "  english-analyze-layout infile.kwg\n"
+      "    report cache lines and pages touched by traversal, word lookups and\n"
+      "    gaddag anchor walks (also -analyze-layout-dawg, -analyze-layout-kbwg),\n"
+      "    where a line is --block=16 nodes (or 8 or 32)\n"
+      "  english-stats infile.kwg\n"
+      "    report node, word and sibling list counts, sharing, depths and headroom\n"
+      "    (also -stats-dawg, -stats-kbwg, -stats-klv2)\n"
+      "  (english-read-kwg... and english-read-kbwg... can take -j 4 after infile\n"
+      "    to dump with 4 threads, the output is the same)\n"
+      "  (any command can also take --stats for per-phase times, peak memory and counters,\n"
+      "    or --stats=json for the same as one line of json,\n"
+      "    or --perf to add hardware counters per phase where available)\n"
       "  (english can also be catalan, dutch, french, german, norwegian, polish,\n"
       "    slovene, spanish, decimal, hex)");
   }
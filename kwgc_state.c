@@ -0,0 +1,68 @@
+// Copyright (C) 2020-2025 Andy Kurnia.
+
+// the builder's states and the hash map that finds equal ones, shared with containerbench.
+
+// define Vec for Bool, U64 and U32 before including.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t arc_index; // refers to states.
+  uint32_t next_index; // refers to states.
+  uint8_t tile;
+  bool accepts;
+} KwgcState;
+
+#define VEC_ELT_NAME KwgcState
+#define VEC_ELT_T KwgcState
+#include "generic_vec.c"
+#undef VEC_ELT_T
+#undef VEC_ELT_NAME
+
+static inline void do_hash(uint64_t *hash, uint8_t data) {
+  *hash = (*hash * 3467) ^ (data ^ 0xff);
+}
+
+static inline uint64_t kwgc_state_hash(KwgcState self[static 1]) {
+  uint64_t hash = 0;
+  do_hash(&hash, self->tile);
+  do_hash(&hash, self->accepts);
+  do_hash(&hash, ((uint8_t *)&self->arc_index)[0]);
+  do_hash(&hash, ((uint8_t *)&self->arc_index)[1]);
+  do_hash(&hash, ((uint8_t *)&self->arc_index)[2]);
+  do_hash(&hash, ((uint8_t *)&self->arc_index)[3]);
+  do_hash(&hash, ((uint8_t *)&self->next_index)[0]);
+  do_hash(&hash, ((uint8_t *)&self->next_index)[1]);
+  do_hash(&hash, ((uint8_t *)&self->next_index)[2]);
+  do_hash(&hash, ((uint8_t *)&self->next_index)[3]);
+  return hash;
+}
+
+static inline bool kwgc_state_eql(KwgcState a[static 1], KwgcState b[static 1]) {
+#ifndef __clang__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+  return a->tile == b->tile &&
+    a->accepts == b->accepts &&
+    a->arc_index == b->arc_index &&
+    a->next_index == b->next_index;
+#ifndef __clang__
+#pragma GCC diagnostic pop
+#endif
+}
+
+#define KHM_K_NAME KwgcState
+#define KHM_K_T KwgcState
+#define KHM_K_HASHFUNC kwgc_state_hash
+#define KHM_K_EQLFUNC kwgc_state_eql
+#define KHM_V_NAME U32
+#define KHM_V_T uint32_t
+#include "generic_khm.c"
+#undef KHM_V_T
+#undef KHM_V_NAME
+#undef KHM_K_EQLFUNC
+#undef KHM_K_HASHFUNC
+#undef KHM_K_T
+#undef KHM_K_NAME
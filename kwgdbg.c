@@ -6,14 +6,15 @@
 #include <stdint.h>
 #include <sys/mman.h>
 
-typedef struct { uint32_t p : 22; bool e : 1, d : 1; uint8_t c : 8; } KwgNode; // compiler-specific UB.
+#include "nodes.c"
 
-void dump_kwg(KwgNode *kwg, char s[static 1], size_t l, uint32_t p) {
+void dump_kwg(const uint32_t *kwg, char s[static 1], size_t l, uint32_t p) {
   for (; p > 0; ++p) {
-    s[l] = (char)(kwg[p].c | 0x40); // english only.
-    if (kwg[p].d) printf("%.*s\n", (int)(l + 1), s);
-    if (kwg[p].p) dump_kwg(kwg, s, l + 1, kwg[p].p);
-    if (kwg[p].e) break;
+    uint32_t node = node_at(kwg, p);
+    s[l] = (char)(kwg_node_c(node) | 0x40); // english only.
+    if (kwg_node_d(node)) printf("%.*s\n", (int)(l + 1), s);
+    if (kwg_node_p(node)) dump_kwg(kwg, s, l + 1, kwg_node_p(node));
+    if (kwg_node_e(node)) break;
   }
 }
 
@@ -30,10 +31,10 @@ int main(int argc, char **argv) {
   off_t kwg_size_signed = ftello(f); if (kwg_size_signed < 0) { perror("ftello"); goto errored; }
   size_t kwg_size = (size_t)kwg_size_signed;
   if ((kwg_size & 3) != 0 || !((size_t)dawgroot < (kwg_size >> 2))) { fputs("unexpected file size\n", stderr); goto errored; }
-  KwgNode *kwg = mmap(NULL, kwg_size, PROT_READ, MAP_SHARED, fileno(f), 0); if (!kwg) { perror("mmap"); goto errored; } defer_munmap = true;
+  uint32_t *kwg = mmap(NULL, kwg_size, PROT_READ, MAP_SHARED, fileno(f), 0); if (kwg == MAP_FAILED) { perror("mmap"); goto errored; } defer_munmap = true;
   defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
   char buf[64]; // risky!
-  dump_kwg(kwg, buf, 0, kwg[dawgroot].p);
+  dump_kwg(kwg, buf, 0, kwg_node_p(node_at(kwg, (uint32_t)dawgroot)));
   goto cleanup;
 errored: errored = true;
 cleanup:
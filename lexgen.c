@@ -0,0 +1,341 @@
+// Copyright (C) 2020-2025 Andy Kurnia.
+
+// deterministic synthetic lexicons for benchmarking.
+// the same args always produce the same output.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.c"
+#include "tiles.c"
+
+// malloc helpers
+
+static inline void *not_null_or_die(void *ptr) {
+  if (!ptr) { perror("not_null_or_die"); abort(); }
+  return ptr;
+}
+
+static inline void *malloc_or_die(size_t size) {
+  return not_null_or_die(malloc(size));
+}
+
+// random helpers
+
+// picks index i with probability weights[i] / sum(weights).
+static inline uint32_t rng_weighted(uint64_t state[static 1], const uint32_t *weights, uint32_t total) {
+  uint32_t r = rng_below(state, total);
+  uint32_t i = 0;
+  while (r >= weights[i]) r -= weights[i++];
+  return i;
+}
+
+// languages
+
+#define MAX_TILES 64
+#define MAX_WORD_LEN 15
+
+// bag counts give a realistic letter distribution. index 0 is the blank.
+typedef struct {
+  const char *name;
+  Tile *tileset;
+  uint8_t num_tiles;
+  uint8_t counts[MAX_TILES];
+} Lang;
+
+Lang langs[] = {
+  {
+    // english_tileset is a pointer, so not usable here.
+    .name = "english", .tileset = dutch_tileset, .num_tiles = 27,
+    .counts = { 2, 9, 2, 2, 4, 12, 2, 3, 2, 9, 1, 1, 4, 2, 6, 8, 2, 1, 6, 4, 6, 4, 2, 2, 1, 2, 1 },
+  },
+  {
+    .name = "german", .tileset = german_tileset, .num_tiles = 30,
+    .counts = { 2, 5, 1, 2, 2, 4, 15, 2, 3, 4, 6, 1, 2, 3, 4, 9, 3, 1, 1, 1, 6, 7, 6, 6, 1, 1, 1, 1, 1, 1 },
+  },
+  {
+    .name = "polish", .tileset = polish_tileset, .num_tiles = 33,
+    .counts = { 2, 9, 1, 2, 3, 1, 3, 7, 1, 1, 2, 2, 8, 2, 3, 3, 2, 3, 5, 1, 6, 1, 3, 4, 4, 1, 3, 2, 4, 4, 5, 1, 1 },
+  },
+  {
+    .name = "catalan", .tileset = catalan_tileset, .num_tiles = 27,
+    .counts = { 2, 12, 2, 3, 1, 3, 13, 1, 2, 1, 8, 1, 4, 1, 3, 6, 1, 5, 2, 1, 8, 8, 5, 4, 1, 1, 1 },
+  },
+};
+
+// roughly the word length distribution of a big english lexicon, from 2 to 15.
+const uint32_t length_weights[MAX_WORD_LEN + 1] = {
+  0, 0, 1, 13, 56, 129, 229, 344, 429, 421, 355, 279, 203, 138, 88, 53,
+};
+
+static bool is_vowel(const char *label) {
+  static const char *vowels[] = { "A", "E", "I", "O", "U", "Y", "Ä", "Ö", "Ü", "Ą", "Ę", "Ó" };
+  for (size_t i = 0; i < sizeof(vowels) / sizeof(*vowels); ++i) if (!strcmp(label, vowels[i])) return true;
+  return false;
+}
+
+typedef struct {
+  Lang *lang;
+  uint32_t vowel_weights[MAX_TILES];
+  uint32_t vowel_total;
+  uint32_t consonant_weights[MAX_TILES];
+  uint32_t consonant_total;
+} Alphabet;
+
+static Alphabet alphabet_new(Lang *lang) {
+  Alphabet ret = { .lang = lang, .vowel_total = 0, .consonant_total = 0 };
+  for (uint32_t i = 1; i < lang->num_tiles; ++i) {
+    bool vowel = is_vowel(lang->tileset[i].label);
+    ret.vowel_weights[i] = vowel ? lang->counts[i] : 0;
+    ret.consonant_weights[i] = vowel ? 0 : lang->counts[i];
+    ret.vowel_total += ret.vowel_weights[i];
+    ret.consonant_total += ret.consonant_weights[i];
+  }
+  return ret;
+}
+
+// syllable-ish: mostly consonant-vowel alternation with the odd cluster.
+static size_t gen_stem(Alphabet alphabet[static 1], uint64_t rng[static 1], uint8_t *out, size_t len) {
+  bool want_vowel = rng_below(rng, 4) == 0;
+  for (size_t i = 0; i < len; ++i) {
+    out[i] = (uint8_t)(want_vowel ?
+      rng_weighted(rng, alphabet->vowel_weights, alphabet->vowel_total) :
+      rng_weighted(rng, alphabet->consonant_weights, alphabet->consonant_total));
+    want_vowel = want_vowel ? rng_below(rng, 5) != 0 : rng_below(rng, 4) != 0;
+  }
+  return len;
+}
+
+// words seen, by 64-bit hash of their tiles. collisions only make the output a word shorter.
+
+typedef struct {
+  uint64_t *slots; // 0 = empty.
+  size_t mask;
+} Seen;
+
+static bool seen_insert(Seen self[static 1], const uint8_t *word, size_t len) {
+  uint64_t h = 0x84222325cbf29ce4;
+  for (size_t i = 0; i < len; ++i) h = (h ^ word[i]) * 0x100000001b3;
+  h = (h ^ len) | 1;
+  for (size_t p = h & self->mask; ; p = (p + 1) & self->mask) {
+    if (!self->slots[p]) { self->slots[p] = h; return true; }
+    if (self->slots[p] == h) return false;
+  }
+}
+
+static void put_word(FILE *f, Lang lang[static 1], const uint8_t *word, size_t len) {
+  for (size_t i = 0; i < len; ++i) fputs(lang->tileset[word[i]].label, f);
+}
+
+#define NUM_SUFFIXES 48
+#define NUM_PARADIGMS 24
+#define MAX_PARADIGM_LEN 12
+#define NUM_PREFIXES 32
+
+// roots inflected by a paradigm (a fixed set of suffixes), sometimes with a prefix,
+// so there is prefix and suffix sharing like in real lexicons.
+static void gen_words(Lang lang[static 1], size_t num_words, uint64_t seed) {
+  uint64_t rng = seed;
+  Alphabet alphabet = alphabet_new(lang);
+  uint8_t suffixes[NUM_SUFFIXES][4];
+  size_t suffix_lens[NUM_SUFFIXES];
+  for (size_t i = 0; i < NUM_SUFFIXES; ++i) {
+    suffix_lens[i] = i ? 1 + rng_below(&rng, 4) : 0; // the first one is empty.
+    gen_stem(&alphabet, &rng, suffixes[i], suffix_lens[i]);
+  }
+  uint8_t paradigms[NUM_PARADIGMS][MAX_PARADIGM_LEN];
+  size_t paradigm_lens[NUM_PARADIGMS];
+  uint32_t paradigm_weights[NUM_PARADIGMS];
+  uint32_t paradigm_total = 0;
+  for (size_t i = 0; i < NUM_PARADIGMS; ++i) {
+    paradigm_lens[i] = 1 + rng_below(&rng, MAX_PARADIGM_LEN);
+    for (size_t j = 0; j < paradigm_lens[i]; ++j) paradigms[i][j] = (uint8_t)rng_below(&rng, NUM_SUFFIXES);
+    paradigm_weights[i] = 1000 / (uint32_t)(i + 1);
+    paradigm_total += paradigm_weights[i];
+  }
+  uint8_t prefixes[NUM_PREFIXES][3];
+  size_t prefix_lens[NUM_PREFIXES];
+  for (size_t i = 0; i < NUM_PREFIXES; ++i) {
+    prefix_lens[i] = 2 + rng_below(&rng, 2);
+    gen_stem(&alphabet, &rng, prefixes[i], prefix_lens[i]);
+  }
+  uint32_t length_total = 0;
+  for (size_t i = 0; i <= MAX_WORD_LEN; ++i) length_total += length_weights[i];
+
+  size_t cap = 16;
+  while (cap < num_words * 2) cap <<= 1;
+  Seen seen = { .slots = malloc_or_die(cap * sizeof(uint64_t)), .mask = cap - 1 };
+  memset(seen.slots, 0, cap * sizeof(uint64_t));
+
+  uint8_t word[MAX_WORD_LEN + 4];
+  size_t num_written = 0;
+  size_t num_tries = 0;
+  while (num_written < num_words && num_tries++ < num_words * 64) {
+    size_t len = rng_weighted(&rng, length_weights, length_total);
+    size_t stem_len = 0;
+    if (len >= 6 && rng_below(&rng, 5) == 0) {
+      uint32_t x = rng_below(&rng, NUM_PREFIXES);
+      memcpy(word, prefixes[x], prefix_lens[x]);
+      stem_len = prefix_lens[x];
+    }
+    uint32_t paradigm = rng_weighted(&rng, paradigm_weights, paradigm_total);
+    size_t root_len = len - stem_len > 4 ? len - stem_len - 2 : 2;
+    gen_stem(&alphabet, &rng, word + stem_len, root_len);
+    stem_len += root_len;
+    for (size_t v = 0; v < paradigm_lens[paradigm] && num_written < num_words; ++v) {
+      uint8_t s = paradigms[paradigm][v];
+      if (stem_len + suffix_lens[s] > MAX_WORD_LEN) continue;
+      memcpy(word + stem_len, suffixes[s], suffix_lens[s]);
+      if (seen_insert(&seen, word, stem_len + suffix_lens[s])) {
+        put_word(stdout, lang, word, stem_len + suffix_lens[s]);
+        putchar('\n');
+        ++num_written;
+      }
+    }
+  }
+  free(seen.slots);
+}
+
+// every multiset of tiles the bag allows, shortest first, until num_leaves.
+
+typedef struct {
+  Lang *lang;
+  uint64_t rng;
+  size_t num_left;
+  uint8_t rack[8];
+} LeavesGen;
+
+static void gen_leaves_rec(LeavesGen self[static 1], size_t len, size_t target_len, uint8_t min_tile) {
+  if (!self->num_left) return;
+  if (len == target_len) {
+    put_word(stdout, self->lang, self->rack, len);
+    // millipoints in [-30, 30), like real leave values.
+    printf(",%.3f\n", (double)((int32_t)rng_below(&self->rng, 60000) - 30000) / 1000);
+    --self->num_left;
+    return;
+  }
+  for (uint8_t t = min_tile; t < self->lang->num_tiles && self->num_left; ++t) {
+    size_t used = 0;
+    for (size_t i = 0; i < len; ++i) used += self->rack[i] == t;
+    if (used >= self->lang->counts[t]) continue;
+    self->rack[len] = t;
+    gen_leaves_rec(self, len + 1, target_len, t);
+  }
+}
+
+static void gen_leaves(Lang lang[static 1], size_t num_leaves, uint64_t seed) {
+  LeavesGen gen = { .lang = lang, .rng = seed, .num_left = num_leaves };
+  for (size_t target_len = 1; target_len <= 7 && gen.num_left; ++target_len) {
+    gen_leaves_rec(&gen, 0, target_len, 0);
+  }
+}
+
+// lookups of the lexicon on stdin (words, or leaves before the comma), for the profiled layout.
+// a seeded shuffle ranks the entries, num_lookups draws pick them with weight 1 / rank like real traffic,
+// and 1 in 20 draws gets a random tile appended, so it mostly misses. prints WORD,count lines.
+
+static void gen_profile(Lang lang[static 1], size_t num_lookups, uint64_t seed) {
+  uint64_t rng = seed;
+  size_t content_len = 0, content_cap = 1 << 20;
+  char *content = malloc_or_die(content_cap);
+  while (true) {
+    content_len += fread(content + content_len, 1, content_cap - content_len - 1, stdin);
+    if (content_len < content_cap - 1) break;
+    content_cap *= 2;
+    content = not_null_or_die(realloc(content, content_cap));
+  }
+  content[content_len] = '\0';
+  size_t num_entries = 0;
+  for (size_t i = 0; i < content_len; ++i) num_entries += content[i] == '\n';
+  // entries[i] is the offset of a nul-terminated entry, in shuffled order.
+  size_t *entries = malloc_or_die((num_entries + 1) * sizeof(size_t));
+  num_entries = 0;
+  for (size_t i = 0; i < content_len; ) {
+    size_t start = i;
+    while (i < content_len && content[i] != '\n') ++i;
+    content[i++] = '\0';
+    char *comma = strchr(content + start, ',');
+    if (comma) *comma = '\0';
+    if (content[start]) entries[num_entries++] = start;
+  }
+  for (size_t i = num_entries; i > 1; --i) {
+    size_t j = rng_below(&rng, (uint32_t)i);
+    size_t t = entries[i - 1]; entries[i - 1] = entries[j]; entries[j] = t;
+  }
+  double *cumulative = malloc_or_die((num_entries + 1) * sizeof(double));
+  uint64_t *counts = malloc_or_die((num_entries + 1) * sizeof(uint64_t));
+  double total = 0;
+  for (size_t i = 0; i < num_entries; ++i) {
+    total += 1.0 / (double)(i + 1);
+    cumulative[i] = total;
+    counts[i] = 0;
+  }
+  uint32_t tile_weights[MAX_TILES];
+  uint32_t tile_total = 0;
+  for (uint32_t i = 0; i < lang->num_tiles; ++i) {
+    tile_weights[i] = i ? lang->counts[i] : 0; // no blanks, words cannot have them.
+    tile_total += tile_weights[i];
+  }
+  for (size_t n = 0; n < num_lookups && num_entries; ++n) {
+    double x = (double)(rng_next(&rng) >> 11) * 0x1p-53 * total;
+    size_t lo = 0, hi = num_entries - 1;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (cumulative[mid] > x) hi = mid; else lo = mid + 1;
+    }
+    if (rng_below(&rng, 20) == 0) {
+      printf("%s%s,1\n", content + entries[lo], lang->tileset[rng_weighted(&rng, tile_weights, tile_total)].label);
+    } else {
+      ++counts[lo];
+    }
+  }
+  for (size_t i = 0; i < num_entries; ++i) {
+    if (counts[i]) printf("%s,%" PRIu64 "\n", content + entries[i], counts[i]);
+  }
+  free(counts);
+  free(cumulative);
+  free(entries);
+  free(content);
+}
+
+int main(int argc, char **argv) {
+  if (argc == 5) {
+    Lang *lang = NULL;
+    for (size_t i = 0; i < sizeof(langs) / sizeof(*langs); ++i) {
+      if (!strcmp(argv[1], langs[i].name)) lang = &langs[i];
+    }
+    char *end;
+    size_t num = strtoull(argv[3], &end, 10);
+    bool num_ok = *argv[3] && !*end;
+    uint64_t seed = strtoull(argv[4], &end, 10);
+    bool seed_ok = *argv[4] && !*end;
+    if (lang && num_ok && seed_ok) {
+      static char buf[1 << 20];
+      setvbuf(stdout, buf, _IOFBF, sizeof(buf));
+      if (!strcmp(argv[2], "words")) {
+        gen_words(lang, num, seed);
+        return fflush(stdout) ? 1 : 0;
+      } else if (!strcmp(argv[2], "leaves")) {
+        gen_leaves(lang, num, seed);
+        return fflush(stdout) ? 1 : 0;
+      } else if (!strcmp(argv[2], "profile")) {
+        gen_profile(lang, num, seed);
+        return fflush(stdout) ? 1 : 0;
+      }
+    }
+  }
+  puts(
+    "args:\n"
+    "  english words 100000 1 > words.txt\n"
+    "    up to 100000 distinct words from seed 1\n"
+    "  english leaves 100000 1 > leaves.csv\n"
+    "    up to 100000 leaves with values, shortest first\n"
+    "  english profile 100000 1 < words.txt > profile.txt\n"
+    "    100000 skewed lookups of the words (or leaves.csv), some missing, as WORD,count\n"
+    "  (english can also be german, polish, catalan)");
+  return 2;
+}
@@ -0,0 +1,281 @@
+// Copyright (C) 2020-2025 Andy Kurnia.
+
+// gaddag move generation workload, to compare kwg layouts by what engines do.
+// no cross-checks and no scoring: for a fixed seed of boards and racks,
+// find every placement (in both directions) that the gaddag allows.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "helpers.c"
+#include "nodes.c"
+
+#define BOARD_DIM 15
+#define RACK_SIZE 7
+#define MAX_TILES 64
+#define NUM_POSITIONS 500
+#define NUM_RUNS 3
+
+// positions
+
+typedef struct {
+  uint8_t squares[BOARD_DIM][BOARD_DIM]; // 0 = empty, else tile.
+  uint8_t rack[MAX_TILES]; // count per tile, [0] = blanks.
+} Position;
+
+// a random dictionary word, by walking random arcs from the dawg root.
+static uint8_t random_word(const uint32_t *kwg, uint64_t rng[static 1], uint8_t word[static BOARD_DIM]) {
+  uint32_t p = kwg_node_p(node_at(kwg, 0));
+  uint8_t len = 0;
+  while (p && len < BOARD_DIM) {
+    uint32_t list_len = 1;
+    while (!kwg_node_e(node_at(kwg, p + list_len - 1))) ++list_len;
+    uint32_t node = node_at(kwg, p + rng_below(rng, list_len));
+    word[len++] = kwg_node_c(node);
+    p = kwg_node_p(node);
+    if (kwg_node_d(node) && (!p || rng_below(rng, 3) == 0)) return len;
+  }
+  return 0;
+}
+
+// tries to put word on the board touching existing tiles (or through the center if empty).
+static bool place_word(Position pos[static 1], const uint8_t *word, uint8_t len, uint64_t rng[static 1], bool is_first) {
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    bool down = rng_below(rng, 2);
+    int row = is_first ? BOARD_DIM / 2 : (int)rng_below(rng, BOARD_DIM);
+    int col = is_first ? BOARD_DIM / 2 - (int)rng_below(rng, len) : (int)rng_below(rng, BOARD_DIM);
+    if (col < 0 || col + len > BOARD_DIM) continue;
+#define SQ(c) (down ? &pos->squares[c][row] : &pos->squares[row][c])
+    if ((col > 0 && *SQ(col - 1)) || (col + len < BOARD_DIM && *SQ(col + len))) continue;
+    bool fits = true, touches = is_first;
+    for (int i = 0; i < len && fits; ++i) {
+      uint8_t t = *SQ(col + i);
+      if (t) { fits = t == word[i]; touches = true; }
+    }
+    if (!fits || !touches) continue;
+    for (int i = 0; i < len; ++i) *SQ(col + i) = word[i];
+#undef SQ
+    return true;
+  }
+  return false;
+}
+
+static void make_position(Position pos[static 1], const uint32_t *kwg, uint8_t num_tiles, uint64_t rng[static 1]) {
+  memset(pos, 0, sizeof(*pos));
+  uint32_t num_words = rng_below(rng, 24); // from an empty board to a late game.
+  bool is_first = true;
+  for (uint32_t i = 0; i < num_words * 4 && num_words; ++i) {
+    uint8_t word[BOARD_DIM];
+    uint8_t len = random_word(kwg, rng, word);
+    if (len >= 2 && place_word(pos, word, len, rng, is_first)) {
+      is_first = false;
+      if (!--num_words) break;
+    }
+  }
+  for (int i = 0; i < RACK_SIZE; ++i) {
+    // one in 25 tiles is a blank, roughly like a real bag.
+    ++pos->rack[rng_below(rng, 25) ? 1 + rng_below(rng, (uint32_t)num_tiles - 1) : 0];
+  }
+}
+
+// move generator
+
+typedef struct {
+  const uint32_t *kwg;
+  uint32_t num_nodes;
+  uint8_t row[BOARD_DIM];
+  uint8_t *rack;
+  int anchor;
+  int leftmost; // empty squares left of this belong to another anchor.
+  uint64_t nodes_visited; // a seek that finds nothing counts as one.
+  uint64_t moves;
+} Gen;
+
+static void gen_left(Gen g[static 1], int col, uint32_t p, int num_played);
+
+static void gen_right(Gen g[static 1], int col, uint32_t p, int num_played);
+
+static inline void gen_left_on(Gen g[static 1], int col, uint32_t node, int num_played) {
+  bool left_is_empty = col == 0 || !g->row[col - 1];
+  if (kwg_node_d(node) && left_is_empty && num_played && (g->anchor + 1 == BOARD_DIM || !g->row[g->anchor + 1])) ++g->moves;
+  uint32_t child = kwg_node_p(node);
+  if (!child) return;
+  if (col > 0 && (g->row[col - 1] || col - 1 >= g->leftmost)) gen_left(g, col - 1, child, num_played);
+  if (left_is_empty && g->anchor + 1 < BOARD_DIM) {
+    // the separator is the first node of a list if present.
+    uint32_t sep = node_at(g->kwg, child);
+    ++g->nodes_visited;
+    if (!kwg_node_c(sep) && kwg_node_p(sep)) gen_right(g, g->anchor + 1, kwg_node_p(sep), num_played);
+  }
+}
+
+static inline void gen_right_on(Gen g[static 1], int col, uint32_t node, int num_played) {
+  bool right_is_empty = col + 1 == BOARD_DIM || !g->row[col + 1];
+  if (kwg_node_d(node) && right_is_empty && num_played) ++g->moves;
+  uint32_t child = kwg_node_p(node);
+  if (child && col + 1 < BOARD_DIM) gen_right(g, col + 1, child, num_played);
+}
+
+// same code, just changed left to right.
+#define GEN_SQUARE(on) \
+  do { \
+    uint8_t t = g->row[col]; \
+    if (t) { \
+      uint32_t q = kwg_seek(g->kwg, g->num_nodes, p, t); \
+      g->nodes_visited += q ? q - p + 1 : 1; \
+      if (q) on(g, col, node_at(g->kwg, q), num_played); \
+    } else { \
+      for (;; ++p) { \
+        uint32_t node = node_at(g->kwg, p); \
+        ++g->nodes_visited; \
+        uint8_t c = kwg_node_c(node); \
+        if (c) { \
+          uint8_t which = g->rack[c] ? c : 0; \
+          if (g->rack[which]) { \
+            --g->rack[which]; \
+            on(g, col, node, num_played + 1); \
+            ++g->rack[which]; \
+          } \
+        } \
+        if (kwg_node_e(node)) break; \
+      } \
+    } \
+  } while (0)
+
+static void gen_left(Gen g[static 1], int col, uint32_t p, int num_played) {
+  GEN_SQUARE(gen_left_on);
+}
+
+static void gen_right(Gen g[static 1], int col, uint32_t p, int num_played) {
+  GEN_SQUARE(gen_right_on);
+}
+
+#undef GEN_SQUARE
+
+// all rows of one orientation. is_anchor has the same orientation as squares.
+static void gen_rows(Gen g[static 1], uint8_t squares[BOARD_DIM][BOARD_DIM], bool is_anchor[BOARD_DIM][BOARD_DIM], uint32_t gaddag_p) {
+  for (int r = 0; r < BOARD_DIM; ++r) {
+    memcpy(g->row, squares[r], BOARD_DIM);
+    for (int c = 0; c < BOARD_DIM; ++c) {
+      if (!is_anchor[r][c]) continue;
+      g->anchor = c;
+      g->leftmost = c;
+      while (g->leftmost > 0 && !g->row[g->leftmost - 1] && !is_anchor[r][g->leftmost - 1]) --g->leftmost;
+      gen_left(g, c, gaddag_p, 0);
+    }
+  }
+}
+
+static void gen_position(Gen g[static 1], Position pos[static 1], uint32_t gaddag_p) {
+  uint8_t transposed[BOARD_DIM][BOARD_DIM];
+  bool is_anchor[BOARD_DIM][BOARD_DIM];
+  bool is_anchor_transposed[BOARD_DIM][BOARD_DIM];
+  bool is_empty_board = true;
+  for (int r = 0; r < BOARD_DIM; ++r) {
+    for (int c = 0; c < BOARD_DIM; ++c) {
+      transposed[c][r] = pos->squares[r][c];
+      is_empty_board &= !pos->squares[r][c];
+      is_anchor[r][c] = !pos->squares[r][c] && (
+        (r > 0 && pos->squares[r - 1][c]) || (r + 1 < BOARD_DIM && pos->squares[r + 1][c]) ||
+        (c > 0 && pos->squares[r][c - 1]) || (c + 1 < BOARD_DIM && pos->squares[r][c + 1]));
+    }
+  }
+  if (is_empty_board) is_anchor[BOARD_DIM / 2][BOARD_DIM / 2] = true;
+  for (int r = 0; r < BOARD_DIM; ++r) for (int c = 0; c < BOARD_DIM; ++c) is_anchor_transposed[c][r] = is_anchor[r][c];
+  g->rack = pos->rack;
+  gen_rows(g, pos->squares, is_anchor, gaddag_p);
+  gen_rows(g, transposed, is_anchor_transposed, gaddag_p);
+}
+
+// one file
+
+static bool bench_file(const char path[static 1], PerfGroup *perf) {
+  bool errored = false;
+  bool defer_fclose = false;
+  bool defer_munmap = false;
+  Position *positions = NULL;
+  FILE *f = fopen(path, "rb"); if (!f) { perror("fopen"); goto errored; } defer_fclose = true;
+  if (fseek(f, 0L, SEEK_END)) { perror("fseek"); goto errored; }
+  off_t kwg_size_signed = ftello(f); if (kwg_size_signed < 0) { perror("ftello"); goto errored; }
+  size_t kwg_size = (size_t)kwg_size_signed;
+  if ((kwg_size & 3) != 0 || kwg_size < 8 || kwg_size >> 2 > 0x400000) { fputs("unexpected file size\n", stderr); goto errored; }
+  uint32_t *kwg = mmap(NULL, kwg_size, PROT_READ, MAP_SHARED, fileno(f), 0); if (kwg == MAP_FAILED) { perror("mmap"); goto errored; } defer_munmap = true;
+  defer_fclose = false; if (fclose(f)) { perror("fclose"); goto errored; }
+  uint32_t num_nodes = (uint32_t)(kwg_size >> 2);
+  uint32_t bad_index;
+  const char *err = kwg_verify(kwg, num_nodes, true, &bad_index);
+  if (err) { fprintf(stderr, "%s: %s at node %u (needs a gaddawg kwg)\n", path, err, bad_index); goto errored; }
+  uint8_t num_tiles = 2;
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    uint8_t c = kwg_node_c(node_at(kwg, i));
+    if (c >= num_tiles) num_tiles = c + 1;
+  }
+  if (num_tiles > MAX_TILES) { fputs("too many tiles\n", stderr); goto errored; }
+
+  // positions depend only on the words, so every layout of a lexicon gets the same ones.
+  positions = malloc(NUM_POSITIONS * sizeof(Position)); if (!positions) { perror("malloc"); goto errored; }
+  uint64_t rng = 1;
+  for (int i = 0; i < NUM_POSITIONS; ++i) make_position(&positions[i], kwg, num_tiles, &rng);
+
+  uint32_t gaddag_p = kwg_node_p(node_at(kwg, 1));
+  uint64_t best_ns = 0, nodes_visited = 0, moves = 0;
+  uint64_t counts[PerfCounter_Count] = { 0 };
+  for (int run = 0; run < NUM_RUNS; ++run) {
+    Gen g = { .kwg = kwg, .num_nodes = num_nodes, .nodes_visited = 0, .moves = 0 };
+    uint64_t run_counts[PerfCounter_Count] = { 0 };
+    if (perf) perf_group_read_deltas(perf, run_counts); // skips what came before.
+    memset(run_counts, 0, sizeof(run_counts));
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < NUM_POSITIONS; ++i) gen_position(&g, &positions[i], gaddag_p);
+    uint64_t elapsed_ns = now_ns() - t0;
+    if (perf) perf_group_read_deltas(perf, run_counts);
+    if (!run || elapsed_ns < best_ns) {
+      best_ns = elapsed_ns;
+      memcpy(counts, run_counts, sizeof(counts));
+    }
+    nodes_visited = g.nodes_visited;
+    moves = g.moves;
+  }
+  printf("%s: %u nodes, %d positions, %" PRIu64 " moves, %" PRIu64 " nodes visited in %.6fs (%.1fM nodes/s)\n",
+    path, num_nodes, NUM_POSITIONS, moves, nodes_visited, (double)best_ns / 1e9, (double)nodes_visited * 1e3 / (double)best_ns);
+  if (perf && perf->leader >= 0) {
+    printf("  per 1000 nodes visited:");
+    for (int i = 0; i < PerfCounter_Count; ++i) {
+      if (perf->fds[i] < 0) continue;
+      printf(" %s %.1f", perf_counter_names[i], (double)counts[i] * 1000 / (double)nodes_visited);
+    }
+    printf("\n");
+  }
+  goto cleanup;
+errored: errored = true;
+cleanup:
+  free(positions);
+  if (defer_munmap) { if (munmap(kwg, kwg_size)) { perror("munmap"); errored = true; } }
+  if (defer_fclose) { if (fclose(f)) { perror("fclose"); errored = true; } }
+  return !errored;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s [--perf] a.kwg [b.kwg ...]\n"
+      "  runs the same positions on each gaddawg kwg (same lexicon, different layouts)\n", argv[0]);
+    return 2;
+  }
+  bool wants_perf = false;
+  PerfGroup perf = { .leader = -1 };
+  int first = 1;
+  if (!strcmp(argv[1], "--perf")) {
+    wants_perf = true;
+    ++first;
+    perf = perf_group_open();
+  }
+  bool ok = true;
+  for (int i = first; i < argc; ++i) ok &= bench_file(argv[i], wants_perf ? &perf : NULL);
+  if (wants_perf) perf_group_close(&perf);
+  return ok ? 0 : 1;
+}
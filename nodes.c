@@ -0,0 +1,696 @@
+// Copyright (C) 2020-2025 Andy Kurnia.
+
+// kwg/kbwg node accessors, shared by the readers.
+
+// nodes are little-endian uint32_t, decoded with shifts and masks (not bitfields).
+// kwg:  bits 0-21 = p (arc index), bit 22 = e (ends sibling list), bit 23 = d (accepts), bits 24-31 = c (tile).
+// kbwg: bits 0-5 = c, bit 6 = e, bit 7 = d, bits 8-31 = p.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define NODES_BIG_ENDIAN 1
+#else
+#define NODES_BIG_ENDIAN 0
+#endif
+
+// uint32_t node = node_at(kwg, p);
+static inline uint32_t node_at(const uint32_t *nodes, uint32_t i) {
+#if NODES_BIG_ENDIAN
+  return __builtin_bswap32(nodes[i]);
+#else
+  return nodes[i];
+#endif
+}
+
+static inline uint32_t kwg_node_p(uint32_t node) { return node & 0x3fffff; }
+static inline bool kwg_node_e(uint32_t node) { return (node >> 22) & 1; }
+static inline bool kwg_node_d(uint32_t node) { return (node >> 23) & 1; }
+static inline uint8_t kwg_node_c(uint32_t node) { return (uint8_t)(node >> 24); }
+
+static inline uint32_t kbwg_node_p(uint32_t node) { return node >> 8; }
+static inline bool kbwg_node_e(uint32_t node) { return (node >> 6) & 1; }
+static inline bool kbwg_node_d(uint32_t node) { return (node >> 7) & 1; }
+static inline uint8_t kbwg_node_c(uint32_t node) { return (uint8_t)(node & 0x3f); }
+
+// batch decode
+
+// 16 nodes make 64 bytes, the block size of the cache-friendly layouts.
+#define NODE_BATCH_LEN 16
+
+// SoA view of NODE_BATCH_LEN consecutive nodes.
+// bit i of e and d is the e and d of node i.
+typedef struct {
+  uint32_t p[NODE_BATCH_LEN];
+  uint8_t c[NODE_BATCH_LEN];
+  uint16_t e;
+  uint16_t d;
+} NodeBatch;
+
+// decodes nodes[i..i + NODE_BATCH_LEN], which must all be readable.
+static inline void kwg_decode_batch(const uint32_t *nodes, uint32_t i, NodeBatch out[static 1]) {
+  nodes += i;
+#if defined(__AVX2__) && !NODES_BIG_ENDIAN
+  __m256i v0 = _mm256_loadu_si256((const __m256i *)nodes);
+  __m256i v1 = _mm256_loadu_si256((const __m256i *)(nodes + 8));
+  __m256i p_mask = _mm256_set1_epi32(0x3fffff);
+  _mm256_storeu_si256((__m256i *)out->p, _mm256_and_si256(v0, p_mask));
+  _mm256_storeu_si256((__m256i *)(out->p + 8), _mm256_and_si256(v1, p_mask));
+  // move bit 22 (e) and bit 23 (d) to the sign bit.
+  out->e = (uint16_t)(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v0, 9))) |
+    (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v1, 9))) << 8));
+  out->d = (uint16_t)(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v0, 8))) |
+    (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v1, 8))) << 8));
+  __m256i c0 = _mm256_srli_epi32(v0, 24);
+  __m256i c1 = _mm256_srli_epi32(v1, 24);
+  __m128i c16_0 = _mm_packs_epi32(_mm256_castsi256_si128(c0), _mm256_extracti128_si256(c0, 1));
+  __m128i c16_1 = _mm_packs_epi32(_mm256_castsi256_si128(c1), _mm256_extracti128_si256(c1, 1));
+  _mm_storeu_si128((__m128i *)out->c, _mm_packus_epi16(c16_0, c16_1));
+#elif defined(__SSE2__) && !NODES_BIG_ENDIAN
+  __m128i v[4];
+  __m128i p_mask = _mm_set1_epi32(0x3fffff);
+  uint32_t e = 0, d = 0;
+  for (int j = 0; j < 4; ++j) {
+    v[j] = _mm_loadu_si128((const __m128i *)(nodes + 4 * j));
+    _mm_storeu_si128((__m128i *)(out->p + 4 * j), _mm_and_si128(v[j], p_mask));
+    e |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(v[j], 9))) << (4 * j);
+    d |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(v[j], 8))) << (4 * j);
+    v[j] = _mm_srli_epi32(v[j], 24);
+  }
+  out->e = (uint16_t)e;
+  out->d = (uint16_t)d;
+  _mm_storeu_si128((__m128i *)out->c, _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3])));
+#else
+  out->e = 0;
+  out->d = 0;
+  for (uint32_t j = 0; j < NODE_BATCH_LEN; ++j) {
+    uint32_t node = node_at(nodes, j);
+    out->p[j] = kwg_node_p(node);
+    out->c[j] = kwg_node_c(node);
+    out->e |= (uint16_t)(kwg_node_e(node) << j);
+    out->d |= (uint16_t)(kwg_node_d(node) << j);
+  }
+#endif
+}
+
+// same code, just changed kwg to kbwg.
+static inline void kbwg_decode_batch(const uint32_t *nodes, uint32_t i, NodeBatch out[static 1]) {
+  nodes += i;
+#if defined(__AVX2__) && !NODES_BIG_ENDIAN
+  __m256i v0 = _mm256_loadu_si256((const __m256i *)nodes);
+  __m256i v1 = _mm256_loadu_si256((const __m256i *)(nodes + 8));
+  _mm256_storeu_si256((__m256i *)out->p, _mm256_srli_epi32(v0, 8));
+  _mm256_storeu_si256((__m256i *)(out->p + 8), _mm256_srli_epi32(v1, 8));
+  // move bit 6 (e) and bit 7 (d) to the sign bit.
+  out->e = (uint16_t)(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v0, 25))) |
+    (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v1, 25))) << 8));
+  out->d = (uint16_t)(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v0, 24))) |
+    (_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(v1, 24))) << 8));
+  __m256i c_mask = _mm256_set1_epi32(0x3f);
+  __m256i c0 = _mm256_and_si256(v0, c_mask);
+  __m256i c1 = _mm256_and_si256(v1, c_mask);
+  __m128i c16_0 = _mm_packs_epi32(_mm256_castsi256_si128(c0), _mm256_extracti128_si256(c0, 1));
+  __m128i c16_1 = _mm_packs_epi32(_mm256_castsi256_si128(c1), _mm256_extracti128_si256(c1, 1));
+  _mm_storeu_si128((__m128i *)out->c, _mm_packus_epi16(c16_0, c16_1));
+#elif defined(__SSE2__) && !NODES_BIG_ENDIAN
+  __m128i v[4];
+  __m128i c_mask = _mm_set1_epi32(0x3f);
+  uint32_t e = 0, d = 0;
+  for (int j = 0; j < 4; ++j) {
+    v[j] = _mm_loadu_si128((const __m128i *)(nodes + 4 * j));
+    _mm_storeu_si128((__m128i *)(out->p + 4 * j), _mm_srli_epi32(v[j], 8));
+    e |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(v[j], 25))) << (4 * j);
+    d |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(v[j], 24))) << (4 * j);
+    v[j] = _mm_and_si128(v[j], c_mask);
+  }
+  out->e = (uint16_t)e;
+  out->d = (uint16_t)d;
+  _mm_storeu_si128((__m128i *)out->c, _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3])));
+#else
+  out->e = 0;
+  out->d = 0;
+  for (uint32_t j = 0; j < NODE_BATCH_LEN; ++j) {
+    uint32_t node = node_at(nodes, j);
+    out->p[j] = kbwg_node_p(node);
+    out->c[j] = kbwg_node_c(node);
+    out->e |= (uint16_t)(kbwg_node_e(node) << j);
+    out->d |= (uint16_t)(kbwg_node_d(node) << j);
+  }
+#endif
+}
+
+// bit i is set if batch->c[i] == c.
+static inline uint32_t node_batch_match(NodeBatch batch[static 1], uint8_t c) {
+#if defined(__SSE2__)
+  __m128i cs = _mm_loadu_si128((const __m128i *)batch->c);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(cs, _mm_set1_epi8((char)c)));
+#else
+  uint32_t ret = 0;
+  for (uint32_t j = 0; j < NODE_BATCH_LEN; ++j) ret |= (uint32_t)(batch->c[j] == c) << j;
+  return ret;
+#endif
+}
+
+// bits of the nodes up to and including the first one with e.
+static inline uint32_t node_batch_list_mask(NodeBatch batch[static 1]) {
+  uint32_t e = batch->e;
+  return e ? ((e & -e) << 1) - 1 : (1u << NODE_BATCH_LEN) - 1;
+}
+
+// sibling scans
+
+// returns the index of the node with tile c in the sibling list starting at p, or 0 if none.
+// num_nodes bounds the batch loads.
+static inline uint32_t kwg_seek(const uint32_t *nodes, uint32_t num_nodes, uint32_t p, uint8_t c) {
+  if (!p) return 0;
+  while (p + NODE_BATCH_LEN <= num_nodes) {
+    NodeBatch batch;
+    kwg_decode_batch(nodes, p, &batch);
+    uint32_t match = node_batch_match(&batch, c) & node_batch_list_mask(&batch);
+    if (match) return p + (uint32_t)__builtin_ctz(match);
+    if (batch.e) return 0;
+    p += NODE_BATCH_LEN;
+  }
+  for (; p < num_nodes; ++p) {
+    uint32_t node = node_at(nodes, p);
+    if (kwg_node_c(node) == c) return p;
+    if (kwg_node_e(node)) break;
+  }
+  return 0;
+}
+
+// same code, just changed kwg to kbwg.
+static inline uint32_t kbwg_seek(const uint32_t *nodes, uint32_t num_nodes, uint32_t p, uint8_t c) {
+  if (!p) return 0;
+  while (p + NODE_BATCH_LEN <= num_nodes) {
+    NodeBatch batch;
+    kbwg_decode_batch(nodes, p, &batch);
+    uint32_t match = node_batch_match(&batch, c) & node_batch_list_mask(&batch);
+    if (match) return p + (uint32_t)__builtin_ctz(match);
+    if (batch.e) return 0;
+    p += NODE_BATCH_LEN;
+  }
+  for (; p < num_nodes; ++p) {
+    uint32_t node = node_at(nodes, p);
+    if (kbwg_node_c(node) == c) return p;
+    if (kbwg_node_e(node)) break;
+  }
+  return 0;
+}
+
+// jump tables
+
+// jump is an outfile.jump from kwgc --jump: num_roots, depth, num_tiles, then per root,
+// num_tiles^k entries for each prefix length k from 1 to depth.
+// returns what chained seeks from root (0 = dawg, 1 = gaddag) for tiles[0..len] would return,
+// or 0 if there is no such prefix. the caller checks root < num_roots and 1 <= len <= depth.
+static inline uint32_t jump_seek(const uint32_t *jump, uint32_t root, const uint8_t *tiles, uint32_t len) {
+  uint32_t depth = node_at(jump, 1);
+  uint32_t num_tiles = node_at(jump, 2);
+  size_t per_root = 0, ofs = 0, level_len = 1;
+  for (uint32_t k = 1; k <= depth; ++k) {
+    if (k == len) ofs = per_root;
+    level_len *= num_tiles;
+    per_root += level_len;
+  }
+  size_t idx = 0;
+  for (uint32_t i = 0; i < len; ++i) {
+    if (tiles[i] >= num_tiles) return 0;
+    idx = idx * num_tiles + tiles[i];
+  }
+  return node_at(jump, (uint32_t)(3 + root * per_root + ofs + idx));
+}
+
+// sidecar masks
+
+// child_masks is an outfile.cmask from kwgc --child-masks: per node, a little-endian uint64_t
+// with bit c set if tile c is in the sibling list from that node to its end.
+static inline uint64_t mask_at(const uint64_t *masks, uint32_t i) {
+#if NODES_BIG_ENDIAN
+  return __builtin_bswap64(masks[i]);
+#else
+  return masks[i];
+#endif
+}
+
+// returns the same as kwg_seek (or kbwg_seek) without reading the nodes,
+// because kwgc writes each sibling list in tile order.
+static inline uint32_t child_mask_seek(const uint64_t *child_masks, uint32_t p, uint8_t c) {
+  if (!p || c >= 64) return 0;
+  uint64_t mask = mask_at(child_masks, p);
+  if (!((mask >> c) & 1)) return 0;
+  return p + (uint32_t)__builtin_popcountll(mask & (((uint64_t)1 << c) - 1));
+}
+
+// hooks is an outfile.hooks from kwgc --hooks: per node, two little-endian uint64_t,
+// the tiles that accept and all the tiles in the sibling list from that node to its end.
+typedef struct {
+  uint64_t accepting; // tiles that complete a word.
+  uint64_t any; // tiles that extend the prefix at all.
+} HookMasks;
+
+// for the node reached by a prefix, hook_masks_at(hooks, its p) answers both cross-check questions.
+static inline HookMasks hook_masks_at(const uint64_t *hooks, uint32_t p) {
+  if (!p) return (HookMasks){ .accepting = 0, .any = 0 };
+  return (HookMasks){ .accepting = mask_at(hooks, 2 * p), .any = mask_at(hooks, 2 * p + 1) };
+}
+
+// completion lengths
+
+// lens is an outfile.lens from kwgc --lengths: per node, a little-endian uint32_t with bit k set if
+// a word ends k tiles below that node (bit 0 if the node itself accepts), and bit 31 for 31 or more.
+// in the gaddag part, the separator counts as a tile.
+// returns whether a word ends between min_more and max_more tiles below node i, so a traversal
+// that has only so many squares left can skip the node's subtree when this is false.
+static inline bool length_mask_within(const uint32_t *lens, uint32_t i, uint32_t min_more, uint32_t max_more) {
+  if (min_more > max_more || min_more > 31) return false;
+  if (max_more > 31) max_more = 31;
+  uint32_t range = (uint32_t)(((uint64_t)2 << max_more) - ((uint64_t)1 << min_more));
+  return (node_at(lens, i) & range) != 0;
+}
+
+// word ranks
+
+// counts is an outfile.counts from kwgc --counts: per node, a little-endian uint32_t, the number of
+// words in the sibling list from that node to its end. the roots' own entries are 0.
+// a word's rank is its position in dump order (the order of klv2 values), which counts
+// the words under earlier siblings and the shorter words on the way down.
+
+// returns the rank of tiles[0..len] among the words under the list at p, or (uint32_t)-1 if it is not one.
+static inline uint32_t kwg_word_rank(const uint32_t *nodes, uint32_t num_nodes, const uint32_t *counts, uint32_t p, const uint8_t *tiles, size_t len) {
+  uint32_t rank = 0;
+  for (size_t i = 0; i < len; ++i) {
+    uint32_t q = kwg_seek(nodes, num_nodes, p, tiles[i]);
+    if (!q) break;
+    rank += node_at(counts, p) - node_at(counts, q);
+    uint32_t node = node_at(nodes, q);
+    if (i + 1 == len) return kwg_node_d(node) ? rank : (uint32_t)-1;
+    rank += kwg_node_d(node);
+    p = kwg_node_p(node);
+  }
+  return (uint32_t)-1;
+}
+
+// writes the word of the given rank under the list at p to tiles, returns its length,
+// or 0 if rank is out of range or the word is longer than max_len.
+static inline size_t kwg_word_unrank(const uint32_t *nodes, const uint32_t *counts, uint32_t p, uint32_t rank, uint8_t *tiles, size_t max_len) {
+  size_t len = 0;
+  while (p && len < max_len) {
+    uint32_t node;
+    while (true) {
+      node = node_at(nodes, p);
+      // words through this node alone.
+      uint32_t here = node_at(counts, p) - (kwg_node_e(node) ? 0 : node_at(counts, p + 1));
+      if (rank < here) break;
+      if (kwg_node_e(node)) return 0;
+      rank -= here;
+      ++p;
+    }
+    tiles[len++] = kwg_node_c(node);
+    if (kwg_node_d(node)) {
+      if (!rank) return len;
+      --rank;
+    }
+    p = kwg_node_p(node);
+  }
+  return 0;
+}
+
+// same code, just changed kwg to kbwg.
+static inline uint32_t kbwg_word_rank(const uint32_t *nodes, uint32_t num_nodes, const uint32_t *counts, uint32_t p, const uint8_t *tiles, size_t len) {
+  uint32_t rank = 0;
+  for (size_t i = 0; i < len; ++i) {
+    uint32_t q = kbwg_seek(nodes, num_nodes, p, tiles[i]);
+    if (!q) break;
+    rank += node_at(counts, p) - node_at(counts, q);
+    uint32_t node = node_at(nodes, q);
+    if (i + 1 == len) return kbwg_node_d(node) ? rank : (uint32_t)-1;
+    rank += kbwg_node_d(node);
+    p = kbwg_node_p(node);
+  }
+  return (uint32_t)-1;
+}
+
+// same code, just changed kwg to kbwg.
+static inline size_t kbwg_word_unrank(const uint32_t *nodes, const uint32_t *counts, uint32_t p, uint32_t rank, uint8_t *tiles, size_t max_len) {
+  size_t len = 0;
+  while (p && len < max_len) {
+    uint32_t node;
+    while (true) {
+      node = node_at(nodes, p);
+      // words through this node alone.
+      uint32_t here = node_at(counts, p) - (kbwg_node_e(node) ? 0 : node_at(counts, p + 1));
+      if (rank < here) break;
+      if (kbwg_node_e(node)) return 0;
+      rank -= here;
+      ++p;
+    }
+    tiles[len++] = kbwg_node_c(node);
+    if (kbwg_node_d(node)) {
+      if (!rank) return len;
+      --rank;
+    }
+    p = kbwg_node_p(node);
+  }
+  return 0;
+}
+
+// structural validation
+
+// sets words[i] to the words (accepting paths) in the list from i to its end, for every i reachable from p,
+// of nodes whose arcs all point within nodes to lists that end. other entries are left alone.
+// if tries is not NULL, also sets tries[i] to the nodes the same lists would take without any sharing.
+// states is NULL, or num_nodes zeroed bytes shared by several calls, so nodes counted by one are not redone.
+// returns false if the arcs form a cycle, or if out of memory.
+static inline bool nodes_count_list_words(const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg, uint32_t p, uint64_t *words, uint64_t *tries, uint8_t *states) {
+  if (!p) return true;
+  // state 0 = new, 1 = pending, 2 = counted.
+  uint8_t *own_states = states ? NULL : calloc(num_nodes, sizeof(uint8_t));
+  if (!states) states = own_states;
+  // each index pushes at most 2 entries, when it goes from new to pending.
+  uint32_t *stack = malloc(((size_t)num_nodes * 2 + 1) * sizeof(uint32_t));
+  bool ret = false;
+  if (!states || !stack) goto cleanup;
+  size_t stack_len = 0;
+  stack[stack_len++] = p;
+  while (stack_len) {
+    uint32_t i = stack[stack_len - 1];
+    uint32_t node = node_at(nodes, i);
+    uint32_t child = is_kbwg ? kbwg_node_p(node) : kwg_node_p(node);
+    uint32_t next = (is_kbwg ? kbwg_node_e(node) : kwg_node_e(node)) ? 0 : i + 1;
+    if (states[i] == 2) {
+      --stack_len;
+    } else if (states[i] == 0) {
+      states[i] = 1;
+      if (child && states[child] == 1) goto cleanup;
+      if (next && states[next] == 1) goto cleanup;
+      if (child && !states[child]) stack[stack_len++] = child;
+      if (next && !states[next] && next != child) stack[stack_len++] = next;
+    } else {
+      // both dependencies have been counted.
+      words[i] = (is_kbwg ? kbwg_node_d(node) : kwg_node_d(node)) + (child ? words[child] : 0) + (next ? words[next] : 0);
+      if (tries) tries[i] = 1 + (child ? tries[child] : 0) + (next ? tries[next] : 0);
+      states[i] = 2;
+      --stack_len;
+    }
+  }
+  ret = true;
+cleanup:
+  free(stack);
+  free(own_states);
+  return ret;
+}
+
+// one pass over nodes, checking what traversal relies on:
+// the roots (node 0, and node 1 if is_gaddag) end their own list and point within nodes,
+// every arc points within nodes (but not at the roots) to a list that ends (e) before nodes do,
+// and for gaddag, separators (tile 0) do not accept, lead somewhere, and are not in a root list.
+// then walks from the roots, checking that the arcs do not form a cycle.
+// returns NULL if fine, otherwise what is wrong and *pbad_index.
+static inline const char *nodes_verify(const uint32_t *nodes, uint32_t num_nodes, bool is_kbwg, bool is_gaddag, uint32_t pbad_index[static 1]) {
+  uint32_t num_roots = is_gaddag ? 2 : 1;
+  *pbad_index = 0;
+  if (num_nodes < num_roots) return "too few nodes";
+  uint32_t max_p = 0, max_p_index = 0, last_e_index = 0;
+  for (uint32_t base = 0; base < num_nodes; base += NODE_BATCH_LEN) {
+    NodeBatch batch;
+    uint32_t batch_len = NODE_BATCH_LEN;
+    if (base + NODE_BATCH_LEN <= num_nodes) {
+      if (is_kbwg) kbwg_decode_batch(nodes, base, &batch); else kwg_decode_batch(nodes, base, &batch);
+    } else {
+      // the last few nodes, one at a time.
+      batch_len = num_nodes - base;
+      batch.e = 0;
+      batch.d = 0;
+      for (uint32_t j = 0; j < batch_len; ++j) {
+        uint32_t node = node_at(nodes, base + j);
+        batch.p[j] = is_kbwg ? kbwg_node_p(node) : kwg_node_p(node);
+        batch.c[j] = is_kbwg ? kbwg_node_c(node) : kwg_node_c(node);
+        batch.e |= (uint16_t)((is_kbwg ? kbwg_node_e(node) : kwg_node_e(node)) << j);
+        batch.d |= (uint16_t)((is_kbwg ? kbwg_node_d(node) : kwg_node_d(node)) << j);
+      }
+    }
+    for (uint32_t j = 0; j < batch_len; ++j) {
+      uint32_t i = base + j;
+      uint32_t p = batch.p[j];
+      bool e = (batch.e >> j) & 1;
+      bool d = (batch.d >> j) & 1;
+      *pbad_index = i;
+      if (p >= num_nodes) return "arc points past the end";
+      if (p && p < num_roots) return "arc points to a root";
+      if (p > max_p) max_p = p, max_p_index = i;
+      if (e) last_e_index = i;
+      if (i < num_roots) {
+        if (!e) return "root does not end its list";
+      } else if (is_gaddag && !batch.c[j] && (p || e || d)) {
+        // all-zero nodes are gaps left by the cache-friendly layouts.
+        if (d) return "separator accepts";
+        if (!p) return "separator leads nowhere";
+      }
+    }
+  }
+  // every list ends at or before the last e, so only the furthest arc matters.
+  *pbad_index = max_p_index;
+  if (max_p > last_e_index) return "sibling list runs past the end";
+  if (is_gaddag) {
+    for (uint32_t r = 0; r < num_roots; ++r) {
+      uint32_t node = node_at(nodes, r);
+      for (uint32_t p = is_kbwg ? kbwg_node_p(node) : kwg_node_p(node); p > 0; ++p) {
+        node = node_at(nodes, p);
+        *pbad_index = p;
+        if (!(is_kbwg ? kbwg_node_c(node) : kwg_node_c(node))) return "separator in root list";
+        if (is_kbwg ? kbwg_node_e(node) : kwg_node_e(node)) break;
+      }
+    }
+  }
+  // arcs may point backwards in some layouts, so this needs the full walk.
+  uint64_t *words = malloc(num_nodes * sizeof(uint64_t));
+  uint8_t *states = calloc(num_nodes, sizeof(uint8_t));
+  const char *ret = NULL;
+  if (!words || !states) { *pbad_index = 0; ret = "out of memory"; goto cleanup; }
+  for (uint32_t r = 0; r < num_roots; ++r) {
+    uint32_t node = node_at(nodes, r);
+    *pbad_index = r;
+    if (!nodes_count_list_words(nodes, num_nodes, is_kbwg, is_kbwg ? kbwg_node_p(node) : kwg_node_p(node), words, NULL, states)) {
+      ret = "arcs form a cycle";
+      goto cleanup;
+    }
+  }
+cleanup:
+  free(states);
+  free(words);
+  return ret;
+}
+
+// const char *err = kwg_verify(kwg, num_nodes, is_gaddag, &bad_index);
+static inline const char *kwg_verify(const uint32_t *nodes, uint32_t num_nodes, bool is_gaddag, uint32_t pbad_index[static 1]) {
+  return nodes_verify(nodes, num_nodes, false, is_gaddag, pbad_index);
+}
+
+// const char *err = kbwg_verify(kbwg, num_nodes, is_gaddag, &bad_index);
+static inline const char *kbwg_verify(const uint32_t *nodes, uint32_t num_nodes, bool is_gaddag, uint32_t pbad_index[static 1]) {
+  return nodes_verify(nodes, num_nodes, true, is_gaddag, pbad_index);
+}
+
+// sets counts[i] to the words (accepting paths) in the list from i to its end, for every i reachable from p,
+// of a kwg that passed kwg_verify. other entries are left alone.
+// returns false if the arcs form a cycle, or if out of memory.
+static inline bool kwg_count_list_words(const uint32_t *nodes, uint32_t num_nodes, uint32_t p, uint64_t *counts) {
+  return nodes_count_list_words(nodes, num_nodes, false, p, counts, NULL, NULL);
+}
+
+// counts words (accepting paths) in the list starting at p, of a kwg that passed kwg_verify.
+// returns (uint64_t)-1 if the arcs form a cycle, or if out of memory.
+static inline uint64_t kwg_count_words(const uint32_t *nodes, uint32_t num_nodes, uint32_t p) {
+  if (!p) return 0;
+  uint64_t *counts = malloc(num_nodes * sizeof(uint64_t));
+  uint64_t ret = counts && kwg_count_list_words(nodes, num_nodes, p, counts) ? counts[p] : (uint64_t)-1;
+  free(counts);
+  return ret;
+}
+
+// klv2 is num_kwg_nodes, kwg, num_values, values, all little-endian uint32_t.
+// checks the kwg, and that there is exactly one value per word.
+static inline const char *klv2_verify(const uint32_t *words, size_t num_words, uint32_t pbad_index[static 1]) {
+  *pbad_index = 0;
+  if (num_words < 2) return "too short";
+  uint32_t num_kwg_nodes = node_at(words, 0);
+  if (num_words - 2 < num_kwg_nodes) return "kwg runs past the end";
+  const char *err = kwg_verify(words + 1, num_kwg_nodes, false, pbad_index);
+  if (err) return err;
+  *pbad_index = 0;
+  uint32_t num_values = node_at(words, 1 + num_kwg_nodes);
+  if (num_words - 2 - num_kwg_nodes != num_values) return "value count does not match file size";
+  uint64_t num_words_in_kwg = kwg_count_words(words + 1, num_kwg_nodes, kwg_node_p(node_at(words + 1, 0)));
+  if (num_words_in_kwg == (uint64_t)-1) return "arcs form a cycle";
+  if (num_words_in_kwg != num_values) return "value count does not match word count";
+  return NULL;
+}
+
+// klv2 lookup
+
+// longer racks are never found.
+#define KLV2_MAX_LEAVE_LEN 64
+
+typedef struct {
+  const uint32_t *kwg;
+  uint32_t num_kwg_nodes;
+  const uint32_t *values; // little-endian float bits, in dump order.
+  uint32_t *counts; // per kwg node, like outfile.counts from kwgc --counts.
+} Klv2Lookup;
+
+// klv2 must have passed klv2_verify, and must outlive ret. returns false if out of memory.
+static inline bool klv2_lookup_init(Klv2Lookup ret[static 1], const uint32_t *klv2) {
+  uint32_t num_kwg_nodes = node_at(klv2, 0);
+  ret->kwg = klv2 + 1;
+  ret->num_kwg_nodes = num_kwg_nodes;
+  ret->values = klv2 + 2 + num_kwg_nodes;
+  ret->counts = malloc(num_kwg_nodes * sizeof(uint32_t));
+  uint64_t *counts = calloc(num_kwg_nodes, sizeof(uint64_t));
+  bool ok = ret->counts && counts && kwg_count_list_words(ret->kwg, num_kwg_nodes, kwg_node_p(node_at(ret->kwg, 0)), counts);
+  // klv2_verify checked that the counts fit, as there is a value per word.
+  for (uint32_t i = 0; ok && i < num_kwg_nodes; ++i) {
+#if NODES_BIG_ENDIAN
+    ret->counts[i] = __builtin_bswap32((uint32_t)counts[i]);
+#else
+    ret->counts[i] = (uint32_t)counts[i];
+#endif
+  }
+  free(counts);
+  if (!ok) { free(ret->counts); ret->counts = NULL; }
+  return ok;
+}
+
+static inline void klv2_lookup_free(Klv2Lookup self[static 1]) {
+  free(self->counts);
+  self->counts = NULL;
+}
+
+// returns the index of the value for rack[0..len], or (uint32_t)-1 if there is none.
+// rack is tile indexes (0 for blank) in any order, sorted here the way kwgc sorts leaves.
+static inline uint32_t klv2_leave_index(const Klv2Lookup self[static 1], const uint8_t *rack, size_t len) {
+  if (len > KLV2_MAX_LEAVE_LEN) return (uint32_t)-1;
+  uint8_t tiles[KLV2_MAX_LEAVE_LEN];
+  // insertion sort, racks are short.
+  for (size_t i = 0; i < len; ++i) {
+    size_t j = i;
+    for (; j > 0 && tiles[j - 1] > rack[i]; --j) tiles[j] = tiles[j - 1];
+    tiles[j] = rack[i];
+  }
+  return kwg_word_rank(self->kwg, self->num_kwg_nodes, self->counts, kwg_node_p(node_at(self->kwg, 0)), tiles, len);
+}
+
+// returns the value at an index from klv2_leave_index.
+static inline float klv2_value_at(const Klv2Lookup self[static 1], uint32_t i) {
+  uint32_t value_bits = node_at(self->values, i);
+  float value;
+  memcpy(&value, &value_bits, sizeof(value));
+  return value;
+}
+
+// returns the value for rack[0..len], or 0 if there is none (which includes the empty rack).
+static inline float klv2_leave_value(const Klv2Lookup self[static 1], const uint8_t *rack, size_t len) {
+  uint32_t i = klv2_leave_index(self, rack, len);
+  return i == (uint32_t)-1 ? 0 : klv2_value_at(self, i);
+}
+
+// dense leave tables
+
+// a .kld from kwgc -klv-dense is alphabet_size, max_len (little-endian uint32_t), then one little-endian float
+// per multiset of up to max_len tiles below alphabet_size, in klv_dense_index order (KLV_DENSE_MISSING if not in the csv).
+#define KLV_DENSE_MAX_ALPHABET 64
+#define KLV_DENSE_MAX_LEN 16
+#define KLV_DENSE_MISSING 0x7fc00000 // the bits of a quiet nan.
+
+typedef struct {
+  uint32_t alphabet_size;
+  uint32_t max_len;
+  uint64_t offsets[KLV_DENSE_MAX_LEN + 2]; // [len] = racks shorter than len.
+  uint64_t binomials[KLV_DENSE_MAX_LEN][KLV_DENSE_MAX_ALPHABET + KLV_DENSE_MAX_LEN]; // [i][s] = s choose (i + 1).
+  const uint32_t *values; // NULL when only indexing.
+} KlvDense;
+
+// n choose r, for the small n here.
+static inline uint64_t klv_dense_choose(uint32_t n, uint32_t r) {
+  if (r > n) return 0;
+  uint64_t ret = 1;
+  for (uint32_t j = 1; j <= r; ++j) ret = ret * (n - r + j) / j; // always exact.
+  return ret;
+}
+
+// sets up the index for alphabet_size and max_len, which must be within the maximums above.
+static inline void klv_dense_init_shape(KlvDense ret[static 1], uint32_t alphabet_size, uint32_t max_len) {
+  ret->alphabet_size = alphabet_size;
+  ret->max_len = max_len;
+  ret->values = NULL;
+  // multisets of len tiles from alphabet_size are (alphabet_size + len - 1) choose len.
+  ret->offsets[0] = 0;
+  for (uint32_t len = 0; len <= max_len; ++len) ret->offsets[len + 1] = ret->offsets[len] + klv_dense_choose(alphabet_size + len - 1, len);
+  for (uint32_t i = 0; i < max_len; ++i) {
+    for (uint32_t s = 0; s < alphabet_size + max_len; ++s) ret->binomials[i][s] = klv_dense_choose(s, i + 1);
+  }
+}
+
+// the number of values in the table.
+static inline uint64_t klv_dense_num_racks(const KlvDense self[static 1]) {
+  return self->offsets[self->max_len + 1];
+}
+
+// checks the header and that the file has exactly one value per rack.
+static inline const char *klv_dense_verify(const uint32_t *words, size_t num_words) {
+  if (num_words < 2) return "too short";
+  uint32_t alphabet_size = node_at(words, 0);
+  uint32_t max_len = node_at(words, 1);
+  if (!alphabet_size || alphabet_size > KLV_DENSE_MAX_ALPHABET) return "alphabet size out of range";
+  if (max_len > KLV_DENSE_MAX_LEN) return "max rack length out of range";
+  KlvDense shape;
+  klv_dense_init_shape(&shape, alphabet_size, max_len);
+  if (num_words - 2 != klv_dense_num_racks(&shape)) return "value count does not match file size";
+  return NULL;
+}
+
+// kld must have passed klv_dense_verify, and must outlive ret.
+static inline void klv_dense_init(KlvDense ret[static 1], const uint32_t *kld) {
+  klv_dense_init_shape(ret, node_at(kld, 0), node_at(kld, 1));
+  ret->values = kld + 2;
+}
+
+// returns the index of rack[0..len] (tile indexes in any order), or (uint64_t)-1 if it is not in the table.
+// sorted t[0] <= t[1] <= ... map to distinct t[i] + i, whose combinatorial number system rank
+// is the sum of (t[i] + i) choose (i + 1), after all the shorter racks.
+static inline uint64_t klv_dense_index(const KlvDense self[static 1], const uint8_t *rack, size_t len) {
+  if (len > self->max_len) return (uint64_t)-1;
+  uint8_t tiles[KLV_DENSE_MAX_LEN];
+  // insertion sort, racks are short.
+  for (size_t i = 0; i < len; ++i) {
+    if (rack[i] >= self->alphabet_size) return (uint64_t)-1;
+    size_t j = i;
+    for (; j > 0 && tiles[j - 1] > rack[i]; --j) tiles[j] = tiles[j - 1];
+    tiles[j] = rack[i];
+  }
+  uint64_t ret = self->offsets[len];
+  for (size_t i = 0; i < len; ++i) ret += self->binomials[i][tiles[i] + i];
+  return ret;
+}
+
+// returns the value at an index from klv_dense_index, nan if the rack was not in the csv.
+static inline float klv_dense_value_at(const KlvDense self[static 1], uint64_t i) {
+  uint32_t value_bits = node_at(self->values, (uint32_t)i);
+  float value;
+  memcpy(&value, &value_bits, sizeof(value));
+  return value;
+}
+
+// returns the value for rack[0..len], or 0 if it is not in the table or was not in the csv (like klv2_leave_value).
+static inline float klv_dense_value(const KlvDense self[static 1], const uint8_t *rack, size_t len) {
+  uint64_t i = klv_dense_index(self, rack, len);
+  if (i == (uint64_t)-1) return 0;
+  float value = klv_dense_value_at(self, i);
+  return value == value ? value : 0;
+}